@@ -24,13 +24,51 @@
 #ifndef _NPS_RANGE_
 #define _NPS_RANGE_
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
+#include <array>
 #include <vector>
 #include <list>
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#if defined(__has_include)
+    #if __has_include(<version>)
+        #include <version>
+    #endif // __has_include(<version>)
+#endif // defined(__has_include)
+#if defined(__cpp_lib_ranges)
+    #include <ranges>
+#endif // defined(__cpp_lib_ranges)
+#if defined(__cpp_lib_span)
+    #include <span>
+#endif // defined(__cpp_lib_span)
+#if defined(__cpp_lib_memory_resource)
+    #include <memory_resource>
+#endif // defined(__cpp_lib_memory_resource)
+#if defined(__cpp_lib_bitops)
+    #include <bit>
+#endif // defined(__cpp_lib_bitops)
+
 #if _HAS_CXX17
     #define _NPS_CONSTEXPR17 constexpr 
 #else  // _HAS_CXX17
@@ -52,6 +90,35 @@
     #endif // _DEBUG
 #endif //  !defined(_NPS_ASSERT)
 
+// Vectorized kernels are selected from the instruction sets enabled at compile time.
+// Define _NPS_NO_SIMD to always use the scalar paths.
+#if !defined(_NPS_NO_SIMD)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define _NPS_SSE2 1
+    #endif // SSE2
+    #if defined(__AVX2__)
+        #define _NPS_AVX2 1
+    #endif // __AVX2__
+    #if defined(__AVX512F__)
+        #define _NPS_AVX512F 1
+    #endif // __AVX512F__
+    #if defined(__AVX512BW__)
+        #define _NPS_AVX512BW 1
+    #endif // __AVX512BW__
+    #if defined(__BMI2__)
+        #define _NPS_BMI2 1
+    #endif // __BMI2__
+    #if defined(_NPS_SSE2)
+        #include <immintrin.h>
+    #endif // defined(_NPS_SSE2)
+#endif // !defined(_NPS_NO_SIMD)
+
+// Floating elements are computed as start + index * step with a single rounding when the target has FMA.
+// The scalar and vectorized paths follow the same macro, so they always produce identical values.
+#if !defined(_NPS_FMA) && (defined(__FMA__) || defined(__ARM_FEATURE_FMA))
+    #define _NPS_FMA 1
+#endif // !defined(_NPS_FMA) && (defined(__FMA__) || defined(__ARM_FEATURE_FMA))
+
 #if defined(_MSC_VER) && !_HAS_CXX17
     #pragma warning(push)
     #pragma warning(disable : 4984)
@@ -59,531 +126,4752 @@
 
 namespace nps
 {
-    template <class _Ty, class _Sty, std::enable_if_t<std::is_arithmetic_v<_Ty>&& std::is_arithmetic_v<_Sty>, int> = 0>
-    class range_iterator
+    namespace detail
     {
-    public:
-        template <class, class>
-        friend class circular_range_iterator;
-        template <class, class, class>
-        friend class patterned_range_iterator;
-
-        _NPS_CONSTEXPR17 range_iterator() = default;
-
-        _NPS_CONSTEXPR17 range_iterator(_Ty value, _Sty step) : m_value(value), m_step(step) {}
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 uint128_t;
+#endif // defined(__SIZEOF_INT128__)
 
-        _NPS_CONSTEXPR17 range_iterator(const range_iterator& other) : m_value(other.m_value), m_step(other.m_step) {}
-
-        _NPS_CONSTEXPR17 range_iterator& operator=(const range_iterator& other)
+        // Non-negative remainder of value modulo modulus. modulus must be greater than 0.
+        template <class _Ty>
+        constexpr unsigned long long floor_mod(_Ty value, unsigned long long modulus) noexcept
         {
-            m_value = other.m_value;
-            m_step = other.m_step;
-            return *this;
+            if constexpr (std::is_signed_v<_Ty>)
+            {
+                if (value < 0)
+                {
+                    const unsigned long long remainder = (static_cast<unsigned long long>(-(value + 1)) + 1) % modulus;
+                    return remainder == 0 ? 0 : modulus - remainder;
+                }
+            }
+            return static_cast<unsigned long long>(value) % modulus;
         }
 
-        _NPS_CONSTEXPR17 range_iterator(range_iterator&& other) noexcept : m_value(std::move(other.m_value)), m_step(std::move(other.m_step)) {}
-
-        _NPS_CONSTEXPR17 _Ty operator*() const
+        constexpr unsigned long long add_mod(unsigned long long a, unsigned long long b, unsigned long long modulus) noexcept
         {
-            return m_value;
+            return (a >= modulus - b) ? a - (modulus - b) : a + b;
         }
 
-        _NPS_CONSTEXPR17 range_iterator& operator++()
+        constexpr unsigned long long sub_mod(unsigned long long a, unsigned long long b, unsigned long long modulus) noexcept
         {
-            m_value += static_cast<_Ty>(m_step);
-            return (*this);
+            return (a >= b) ? a - b : a + (modulus - b);
         }
 
-        _NPS_CONSTEXPR17 range_iterator operator++(int)
+        // a * b modulo modulus for a, b < modulus.
+        constexpr unsigned long long mul_mod(unsigned long long a, unsigned long long b, unsigned long long modulus) noexcept
         {
-            range_iterator temp = *this;
-            m_value += static_cast<_Ty>(m_step);
-            return temp;
+#if defined(__SIZEOF_INT128__)
+            return static_cast<unsigned long long>((static_cast<uint128_t>(a) * b) % modulus);
+#else  // defined(__SIZEOF_INT128__)
+            unsigned long long result = 0;
+            while (b != 0)
+            {
+                if (b & 1)
+                    result = add_mod(result, a, modulus);
+                a = add_mod(a, a, modulus);
+                b >>= 1;
+            }
+            return result;
+#endif // defined(__SIZEOF_INT128__)
         }
 
-        _NPS_CONSTEXPR17 range_iterator& operator--()
+        // Inverse of a modulo modulus by the extended Euclidean algorithm. gcd(a, modulus) must be 1.
+        constexpr unsigned long long inverse_mod(unsigned long long a, unsigned long long modulus) noexcept
         {
-            m_value -= static_cast<_Ty>(m_step);
-            return (*this);
+            unsigned long long r0 = modulus, r1 = a % modulus;
+            unsigned long long t0 = 0, t1 = 1 % modulus;
+            while (r1 != 0)
+            {
+                const unsigned long long q = r0 / r1;
+                const unsigned long long r2 = r0 - q * r1;
+                const unsigned long long t2 = sub_mod(t0, mul_mod(q % modulus, t1, modulus), modulus);
+                r0 = r1; r1 = r2;
+                t0 = t1; t1 = t2;
+            }
+            return t0;
         }
 
-        _NPS_CONSTEXPR17 range_iterator operator--(int)
+        // Solutions i >= 0 of start + i * step = residue (mod modulus) are first, first + period, ...
+        struct congruence_solution
         {
-            range_iterator temp = *this;
-            m_value -= static_cast<_Ty>(m_step);
-            return temp;
-        }
+            bool exists;
+            unsigned long long first;
+            unsigned long long period;
+        };
 
-        _NPS_CONSTEXPR17 bool operator==(const range_iterator& right) const
+        template <class _Ty, class _Sty>
+        constexpr congruence_solution solve_index_congruence(_Ty start, _Sty step, unsigned long long modulus, unsigned long long residue) noexcept
         {
-            return ((m_step == right.m_step) && (m_step > 0)) ? (m_value >= right.m_value) : (m_value <= right.m_value);
+            const unsigned long long a = floor_mod(step, modulus);
+            const unsigned long long b = sub_mod(residue % modulus, floor_mod(start, modulus), modulus);
+            const unsigned long long g = std::gcd(a, modulus);
+            if (b % g != 0)
+                return { false, 0, 0 };
+            const unsigned long long period = modulus / g;
+            const unsigned long long first = mul_mod((b / g) % period, inverse_mod((a / g) % period, period), period);
+            return { true, first, period };
         }
 
-        _NPS_CONSTEXPR17 bool operator!=(const range_iterator& right) const
+        // 0 + 1 + ... + (n - 1) modulo 2^64, halving before multiplying.
+        constexpr unsigned long long sum_of_indices(unsigned long long n) noexcept
         {
-            return !this->operator==(right);
+            if (n == 0)
+                return 0;
+            return (n % 2 == 0) ? (n / 2) * (n - 1) : n * ((n - 1) / 2);
         }
 
-    private:
-        _Ty m_value;    // Current value in the range.
-        _Sty m_step;    // Step value for iteration.
-    };
-
-    template <class _Ty, class _Sty>
-    class circular_range_iterator : public range_iterator<_Ty, _Sty>
-    {
-    public:
-        using base = range_iterator<_Ty, _Sty>;
-
-        circular_range_iterator(_Ty start, _Ty end, _Sty step, long long count = 0)
-            : base(start, step), m_start(start), m_end(end), m_max(count), m_count(0) {}
-
-        circular_range_iterator& operator++() noexcept
+        // 0^2 + 1^2 + ... + (n - 1)^2 modulo 2^64, dividing the factors of (n - 1) n (2n - 1) by 2 and 3 first.
+        constexpr unsigned long long sum_of_squared_indices(unsigned long long n) noexcept
         {
-            base::operator++();
-            if(base::m_step > 0 && base::m_value >= m_end)
-                base::m_value = m_start;
-            else if(base::m_step < 0 && base::m_value <= m_end)
-                base::m_value = m_start;
-            if (m_max)
-                m_count++;
-            return *this;
+            if (n == 0)
+                return 0;
+            unsigned long long x = n - 1, y = n, z = 2 * n - 1;
+            if (x % 2 == 0) x /= 2; else y /= 2;
+            if (x % 3 == 0) x /= 3; else if (y % 3 == 0) y /= 3; else z /= 3;
+            return x * y * z;
         }
 
-        _NPS_CONSTEXPR17 bool operator==(const circular_range_iterator& right) const
+        // Number of set bits of bits.
+        constexpr unsigned long long bit_count(std::uint64_t bits) noexcept
         {
-            return m_max == right.m_max && m_max == m_count && m_max != 0;
+#if defined(__cpp_lib_bitops)
+            return static_cast<unsigned long long>(std::popcount(bits));
+#else  // defined(__cpp_lib_bitops)
+            unsigned long long count = 0;
+            for (; bits != 0; bits &= bits - 1)
+                ++count;
+            return count;
+#endif // defined(__cpp_lib_bitops)
         }
 
-        _NPS_CONSTEXPR17 bool operator!=(const circular_range_iterator& right) const
+        // Index of the lowest set bit of bits, which must not be 0.
+        constexpr unsigned long long trailing_zeros(std::uint64_t bits) noexcept
         {
-            return !this->operator==(right);
+#if defined(__cpp_lib_bitops)
+            return static_cast<unsigned long long>(std::countr_zero(bits));
+#else  // defined(__cpp_lib_bitops)
+            unsigned long long index = 0;
+            for (; (bits & 1) == 0; bits >>= 1)
+                ++index;
+            return index;
+#endif // defined(__cpp_lib_bitops)
         }
 
-    private:
-        _Ty m_start; // Beginning of the circular range.
-        _Ty m_end;   // End of the circular range.
-        long long m_max;
-        long long m_count;
-    };
-
-    template <class _Ty, class _Sty, class _Rty>
-    class patterned_range_iterator : public range_iterator<_Ty, _Sty>
-    {
-    public:
-        using base = range_iterator<_Ty, _Sty>;
-
-        patterned_range_iterator(_Ty start, _Sty step, _Ty(*pattern_func)(_Ty))
-            : base(start, step), m_pattern_func(pattern_func) {}
-
-        patterned_range_iterator& operator++() noexcept
+        // The count low bits set, for count up to 64.
+        constexpr std::uint64_t low_bits(unsigned long long count) noexcept
         {
-            base::m_value = m_pattern_func(base::m_value);
-            return (*this);
+            return (count >= 64) ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << count) - 1;
         }
 
-        _NPS_CONSTEXPR17 bool operator==(const patterned_range_iterator& right) const
+        // Index of the set bit of bits with rank n (counting from 0 at the lowest).
+        constexpr unsigned long long nth_set_bit(std::uint64_t bits, unsigned long long n) noexcept
         {
-            return (m_pattern_func == right.m_pattern_func) && base::operator==(right);
+            for (; n != 0; --n)
+                bits &= bits - 1;
+            return trailing_zeros(bits);
         }
 
-        _NPS_CONSTEXPR17 bool operator!=(const patterned_range_iterator& right) const
+        // The low width bits of bits rotated right by shift < width, so that bit shift becomes bit 0.
+        constexpr std::uint64_t rotate_bits(std::uint64_t bits, unsigned long long shift, unsigned long long width) noexcept
         {
-            return !this->operator==(right);
+            return (shift == 0) ? bits : ((bits >> shift) | (bits << (width - shift))) & low_bits(width);
         }
-    private:
-        _Ty(*m_pattern_func)(_Ty);
-    };
+    }
 
-    template <class _Ty = int, std::enable_if_t<std::is_arithmetic_v<_Ty>, int> = 0>
-    class circular_range
+    namespace detail
     {
-    public:
-        using range_type = _Ty;
-        using step_type = std::conditional_t<std::is_integral_v<_Ty>, long long, _Ty>;
-        using size_type = step_type;
-        using iterator = circular_range_iterator<_Ty, step_type>;
-
-        constexpr circular_range() = default;
-
-        constexpr circular_range(_Ty end, long long count = 0)
+        // Value of the element at index in the progression start, start + step, ...
+        template <class _Ty, class _Sty>
+        constexpr _Ty progression_value(_Ty start, _Sty step, std::ptrdiff_t index) noexcept
         {
-            reset(0, end, 1, count);
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                // Computed modulo 2^64, so neither unsigned nor signed types can overflow on the way.
+                return static_cast<_Ty>(static_cast<unsigned long long>(start) + static_cast<unsigned long long>(index) * static_cast<unsigned long long>(step));
+            }
+            else
+            {
+#if defined(_NPS_FMA)
+                if constexpr (std::is_same_v<_Ty, float> || std::is_same_v<_Ty, double>)
+                    return std::fma(static_cast<_Ty>(index), static_cast<_Ty>(step), start);
+#endif // defined(_NPS_FMA)
+                return static_cast<_Ty>(start + static_cast<_Ty>(index) * step);
+            }
         }
 
-        constexpr circular_range(_Ty start, _Ty end, step_type step, long long count = 0)
+        // Exact division by a constant without a division instruction (Granlund and Montgomery): the divisor is
+        // odd * 2^shift, and multiplying a multiple of odd by the inverse of odd modulo 2^64 yields the quotient.
+        struct exact_divisor
         {
-            reset(start, end, step, count);
-        }
+            constexpr exact_divisor() = default;
 
-        constexpr void reset(_Ty start, _Ty end, step_type step = 1, long long count = 0) noexcept
-        {
-#ifdef _DEBUG
-            _NPS_ASSERT(step != 0, "step cannot be equal to 0");
-#else 
-            if (step == 0)
-                step = 1;
-#endif // _DEBUG
+            constexpr explicit exact_divisor(unsigned long long divisor) noexcept
+            {
+                if (divisor == 0)
+                    return;
+                while ((divisor & 1) == 0)
+                {
+                    divisor >>= 1;
+                    ++shift;
+                }
+                // d * d = 1 (mod 8) for odd d, and every Newton step doubles the number of correct low bits.
+                inverse = divisor;
+                for (int i = 0; i < 5; ++i)
+                    inverse *= 2 - divisor * inverse;
+                limit = std::numeric_limits<unsigned long long>::max() / divisor;
+            }
 
-            m_count = count;
-            m_start = start;
-            m_end = end;
-            if (start <= end)
-                m_step = abs(step);
-            else
+            // Whether the divisor divides value; if so, quotient receives value / divisor.
+            constexpr bool divides(unsigned long long value, unsigned long long& quotient) const noexcept
             {
-                if (step > 0)
-                    m_step = step * (-1);
-                else
-                    m_step = step;
+                if ((value & ((1ULL << shift) - 1)) != 0)
+                    return false;
+                const unsigned long long result = (value >> shift) * inverse;
+                if (result > limit)
+                    return false;
+                quotient = result;
+                return true;
             }
-        }
 
-        _NPS_NODISCARD constexpr iterator begin() const noexcept
-        {
-            return iterator(m_start, m_end, m_step, m_count);
-        }
+            unsigned long long inverse = 1;
+            unsigned long long limit = std::numeric_limits<unsigned long long>::max(); // Largest quotient of odd.
+            unsigned shift = 0;
+        };
 
-        _NPS_NODISCARD constexpr iterator end() const noexcept
+        // Reciprocal of a floating divisor, kept in at least double precision.
+        template <class _Ty>
+        struct reciprocal_divisor
         {
-            return iterator(m_end, m_end, m_step, m_count);
-        }
-    private:
-        _Ty m_start;    // Start value of the range.
-        _Ty m_end;      // End value of the range.
-        step_type m_step; // Step value for iteration.
-        long long m_count;
-    };
+            using value_type = std::conditional_t<(sizeof(_Ty) > sizeof(double)), _Ty, double>;
 
-    template <class _Ty = int, std::enable_if_t<std::is_arithmetic_v<_Ty>, int> = 0>
-    class patterned_range
-    {
-    public:
-        using range_type = _Ty;
-        using step_type = std::conditional_t<std::is_integral_v<_Ty>, long long, _Ty>;
-        using size_type = step_type;
-        using iterator = patterned_range_iterator<_Ty, step_type, _Ty>;
+            constexpr reciprocal_divisor() = default;
 
-        constexpr patterned_range() = default;
+            constexpr explicit reciprocal_divisor(_Ty divisor) noexcept
+                : reciprocal(divisor != 0 ? value_type(1) / static_cast<value_type>(divisor) : value_type(0)) {}
 
-        constexpr patterned_range(_Ty end, _Ty(*pattern_fun)(_Ty) = [](_Ty v)->_Ty { return v++; })
-        {
-            reset(0, end, pattern_fun);
-        }
+            value_type reciprocal = 0;
+        };
 
-        constexpr patterned_range(_Ty start, _Ty end, _Ty(*pattern_fun)(_Ty) = [](_Ty v)->_Ty { return v++; })
+        // std::array of make(0), make(1), ..., make(_Size - 1), without default-constructing the elements.
+        template <class _Fn, std::size_t... _Indices>
+        constexpr auto make_array_impl(_Fn& make, std::index_sequence<_Indices...>)
         {
-            reset(start, end, pattern_fun);
+            return std::array<std::decay_t<decltype(make(std::size_t(0)))>, sizeof...(_Indices)>{ { make(_Indices)... } };
         }
-        constexpr void reset(_Ty start, _Ty end, _Ty(*pattern_fun)(_Ty) = [](_Ty v)->_Ty { return v++; }) noexcept
+
+        template <std::size_t _Size, class _Fn>
+        constexpr auto make_array(_Fn&& make)
         {
-            m_start = start;
-            m_end = end;
-            m_negative = (start > end);
-            m_pattern_fun = pattern_fun;
+            return make_array_impl(make, std::make_index_sequence<_Size>{});
         }
 
-        _NPS_NODISCARD constexpr iterator begin() const noexcept
+        // Number of elements of an integral progression from start towards end. The distance is taken
+        // modulo 2^64, which is exact for any two values of the type, so bounds at its limits cannot overflow.
+        template <class _Ty>
+        constexpr std::ptrdiff_t integral_count(_Ty start, _Ty end, long long step) noexcept
         {
-            return iterator(m_start, m_negative ? static_cast<step_type>(-1) : static_cast<step_type>(1), m_pattern_fun);
+            if (start == end)
+                return 0;
+            const auto low = static_cast<unsigned long long>((start < end) ? start : end);
+            const auto high = static_cast<unsigned long long>((start < end) ? end : start);
+            const unsigned long long distance = high - low;
+            const unsigned long long stride = (step < 0) ? 0ULL - static_cast<unsigned long long>(step) : static_cast<unsigned long long>(step);
+            const unsigned long long count = distance / stride + (distance % stride != 0 ? 1 : 0);
+            _NPS_ASSERT(count <= static_cast<unsigned long long>(std::numeric_limits<std::ptrdiff_t>::max()), "range has too many elements");
+            return static_cast<std::ptrdiff_t>(count);
         }
 
-        _NPS_NODISCARD constexpr iterator end() const noexcept
+#if defined(_NPS_SSE2)
+    #if defined(_NPS_FMA)
+        #define _NPS_SIMD_FMADD(prefix, suffix, a, b, c) prefix##_fmadd_##suffix(a, b, c)
+    #else  // defined(_NPS_FMA)
+        #define _NPS_SIMD_FMADD(prefix, suffix, a, b, c) prefix##_add_##suffix(prefix##_mul_##suffix(a, b), c)
+    #endif // defined(_NPS_FMA)
+
+        struct sse2_ops
         {
-            return iterator(m_end, m_negative ? static_cast<step_type>(-1) : static_cast<step_type>(1), m_pattern_fun);
-        }
-    private:
-        _Ty m_start;
-        _Ty m_end;
-        bool m_negative;
-        _Ty(*m_pattern_fun)(_Ty);
-    };
+            using ivec = __m128i;
+            using fvec = __m128;
+            using dvec = __m128d;
+            static constexpr std::size_t bytes = 16;
 
-    template <class _Ty = int, std::enable_if_t<std::is_arithmetic_v<_Ty>, int> = 0>
-    class range
-    {
-    public:
-        using range_type    = _Ty;
-        using step_type     = std::conditional_t<std::is_integral_v<_Ty>, long long, _Ty>;
-        using size_type     = step_type;
-        using iterator      = range_iterator<_Ty, step_type>;
+            static ivec load(const void* p) noexcept { return _mm_loadu_si128(static_cast<const ivec*>(p)); }
+            static void store(void* p, ivec v) noexcept { _mm_storeu_si128(static_cast<ivec*>(p), v); }
 
-        constexpr range() = default;
+            template <std::size_t _Width>
+            static ivec add(ivec a, ivec b) noexcept
+            {
+                if constexpr (_Width == 1) return _mm_add_epi8(a, b);
+                else if constexpr (_Width == 2) return _mm_add_epi16(a, b);
+                else if constexpr (_Width == 4) return _mm_add_epi32(a, b);
+                else return _mm_add_epi64(a, b);
+            }
 
-        constexpr range(_Ty end)
-        {
-            reset(0, end);
-        }
+            static fvec fset(float v) noexcept { return _mm_set1_ps(v); }
+            static fvec to_float(ivec v) noexcept { return _mm_cvtepi32_ps(v); }
+            static fvec fmuladd(fvec a, fvec b, fvec c) noexcept { return _NPS_SIMD_FMADD(_mm, ps, a, b, c); }
+            static void fstore(float* p, fvec v) noexcept { _mm_storeu_ps(p, v); }
 
-        constexpr range(_Ty start, _Ty end, step_type step = 1)
+            static dvec dset(double v) noexcept { return _mm_set1_pd(v); }
+            static dvec dload(const double* p) noexcept { return _mm_loadu_pd(p); }
+            static dvec dadd(dvec a, dvec b) noexcept { return _mm_add_pd(a, b); }
+            static dvec dmuladd(dvec a, dvec b, dvec c) noexcept { return _NPS_SIMD_FMADD(_mm, pd, a, b, c); }
+            static void dstore(double* p, dvec v) noexcept { _mm_storeu_pd(p, v); }
+        };
+#endif // defined(_NPS_SSE2)
+
+#if defined(_NPS_AVX2)
+        struct avx2_ops
         {
-            reset(start, end, step);
-        }
+            using ivec = __m256i;
+            using fvec = __m256;
+            using dvec = __m256d;
+            static constexpr std::size_t bytes = 32;
 
-        constexpr range reset(_Ty start, _Ty end, step_type step = 1) noexcept
+            static ivec load(const void* p) noexcept { return _mm256_loadu_si256(static_cast<const ivec*>(p)); }
+            static void store(void* p, ivec v) noexcept { _mm256_storeu_si256(static_cast<ivec*>(p), v); }
+
+            template <std::size_t _Width>
+            static ivec add(ivec a, ivec b) noexcept
+            {
+                if constexpr (_Width == 1) return _mm256_add_epi8(a, b);
+                else if constexpr (_Width == 2) return _mm256_add_epi16(a, b);
+                else if constexpr (_Width == 4) return _mm256_add_epi32(a, b);
+                else return _mm256_add_epi64(a, b);
+            }
+
+            static fvec fset(float v) noexcept { return _mm256_set1_ps(v); }
+            static fvec to_float(ivec v) noexcept { return _mm256_cvtepi32_ps(v); }
+            static fvec fmuladd(fvec a, fvec b, fvec c) noexcept { return _NPS_SIMD_FMADD(_mm256, ps, a, b, c); }
+            static void fstore(float* p, fvec v) noexcept { _mm256_storeu_ps(p, v); }
+
+            static dvec dset(double v) noexcept { return _mm256_set1_pd(v); }
+            static dvec dload(const double* p) noexcept { return _mm256_loadu_pd(p); }
+            static dvec dadd(dvec a, dvec b) noexcept { return _mm256_add_pd(a, b); }
+            static dvec dmuladd(dvec a, dvec b, dvec c) noexcept { return _NPS_SIMD_FMADD(_mm256, pd, a, b, c); }
+            static void dstore(double* p, dvec v) noexcept { _mm256_storeu_pd(p, v); }
+        };
+#endif // defined(_NPS_AVX2)
+
+#if defined(_NPS_AVX512F)
+        struct avx512_ops
         {
-#ifdef _DEBUG
-            _NPS_ASSERT(step != 0, "step cannot be equal to 0");
-#else 
-            if (step == 0)
-                step = 1;
-#endif // _DEBUG
-            m_start = start;
-            m_end = end;
-            if (start <= end)
-                m_step = abs(step);
-            else
+            using ivec = __m512i;
+            using fvec = __m512;
+            using dvec = __m512d;
+            static constexpr std::size_t bytes = 64;
+
+            static ivec load(const void* p) noexcept { return _mm512_loadu_si512(p); }
+            static void store(void* p, ivec v) noexcept { _mm512_storeu_si512(p, v); }
+
+            template <std::size_t _Width>
+            static ivec add(ivec a, ivec b) noexcept
             {
-                if (step > 0)
-                    m_step = step * (-1);
+#if defined(_NPS_AVX512BW)
+                if constexpr (_Width == 1) return _mm512_add_epi8(a, b);
+                else if constexpr (_Width == 2) return _mm512_add_epi16(a, b);
                 else
-                    m_step = step;
+#endif // defined(_NPS_AVX512BW)
+                if constexpr (_Width == 4) return _mm512_add_epi32(a, b);
+                else return _mm512_add_epi64(a, b);
             }
 
-            if (m_start == m_end)
-                m_step = 0;
+            static fvec fset(float v) noexcept { return _mm512_set1_ps(v); }
+            static fvec to_float(ivec v) noexcept { return _mm512_cvtepi32_ps(v); }
+            static fvec fmuladd(fvec a, fvec b, fvec c) noexcept { return _NPS_SIMD_FMADD(_mm512, ps, a, b, c); }
+            static void fstore(float* p, fvec v) noexcept { _mm512_storeu_ps(p, v); }
 
-            return *this;
-        }
+            static dvec dset(double v) noexcept { return _mm512_set1_pd(v); }
+            static dvec dload(const double* p) noexcept { return _mm512_loadu_pd(p); }
+            static dvec dadd(dvec a, dvec b) noexcept { return _mm512_add_pd(a, b); }
+            static dvec dmuladd(dvec a, dvec b, dvec c) noexcept { return _NPS_SIMD_FMADD(_mm512, pd, a, b, c); }
+            static void dstore(double* p, dvec v) noexcept { _mm512_storeu_pd(p, v); }
+        };
+#endif // defined(_NPS_AVX512F)
 
-        _NPS_NODISCARD constexpr range step(step_type new_step) const noexcept
-        {
-            return range(m_start, m_end, new_step);
-        }
+#if defined(_NPS_AVX512F)
+        using simd_wide_ops = avx512_ops;   // 32 and 64 bit lanes.
+#elif defined(_NPS_AVX2)
+        using simd_wide_ops = avx2_ops;
+#elif defined(_NPS_SSE2)
+        using simd_wide_ops = sse2_ops;
+#endif
 
-        _NPS_NODISCARD constexpr range reverse() const noexcept
+#if defined(_NPS_AVX512BW)
+        using simd_narrow_ops = avx512_ops; // 8 and 16 bit lanes.
+#elif defined(_NPS_AVX2)
+        using simd_narrow_ops = avx2_ops;
+#elif defined(_NPS_SSE2)
+        using simd_narrow_ops = sse2_ops;
+#endif
+
+#if defined(_NPS_SSE2)
+        // Integral lanes hold start + i * step and advance by lanes * step; the additions wrap
+        // exactly like progression_value, so the output is identical to the scalar path.
+        template <class _Ops, class _Ty, class _Sty>
+        inline std::size_t fill_integral_lanes(_Ty* out, std::size_t count, _Ty start, _Sty step, std::ptrdiff_t first) noexcept
         {
-            if (m_step < 0)
+            constexpr std::size_t lanes = _Ops::bytes / sizeof(_Ty);
+            _Ty initial[lanes];
+            _Ty stride[lanes];
+            for (std::size_t lane = 0; lane < lanes; ++lane)
             {
-                return range(m_end + 1, m_start + 1, -m_step);
+                initial[lane] = progression_value(start, step, first + static_cast<std::ptrdiff_t>(lane));
+                stride[lane] = progression_value(_Ty(0), step, static_cast<std::ptrdiff_t>(lanes));
             }
-            return range(m_end - 1, m_start - 1, -m_step);
+            typename _Ops::ivec value = _Ops::load(initial);
+            const typename _Ops::ivec increment = _Ops::load(stride);
+            std::size_t i = 0;
+            for (; i + lanes <= count; i += lanes)
+            {
+                _Ops::store(out + i, value);
+                value = _Ops::template add<sizeof(_Ty)>(value, increment);
+            }
+            return i;
         }
 
-        _NPS_NODISCARD constexpr range scale(_Ty factor) const noexcept
+        // Float lanes convert an exact 32-bit index to float and compute start + i * step.
+        template <class _Ops>
+        inline std::size_t fill_float_lanes(float* out, std::size_t count, float start, float step, std::ptrdiff_t first) noexcept
         {
-            return range(m_start * factor, m_end * factor, m_step * factor);
+            constexpr std::size_t lanes = _Ops::bytes / sizeof(float);
+            if (first < 0 || static_cast<unsigned long long>(first) + count > static_cast<unsigned long long>(std::numeric_limits<int>::max()))
+                return 0;
+            int initial[lanes];
+            int stride[lanes];
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+            {
+                initial[lane] = static_cast<int>(first + static_cast<std::ptrdiff_t>(lane));
+                stride[lane] = static_cast<int>(lanes);
+            }
+            typename _Ops::ivec index = _Ops::load(initial);
+            const typename _Ops::ivec increment = _Ops::load(stride);
+            const typename _Ops::fvec vstart = _Ops::fset(start);
+            const typename _Ops::fvec vstep = _Ops::fset(step);
+            std::size_t i = 0;
+            for (; i + lanes <= count; i += lanes)
+            {
+                _Ops::fstore(out + i, _Ops::fmuladd(_Ops::to_float(index), vstep, vstart));
+                index = _Ops::template add<4>(index, increment);
+            }
+            return i;
         }
 
-        _NPS_NODISCARD constexpr range intersection(const range& other) const noexcept
+        // Double lanes keep the index as a double, which is exact for every reachable index.
+        template <class _Ops>
+        inline std::size_t fill_double_lanes(double* out, std::size_t count, double start, double step, std::ptrdiff_t first) noexcept
         {
-            _Ty new_start = std::max(m_start, other.m_start);
-            _Ty new_end = std::min(m_end, other.m_end);
-            if (new_start >= new_end)
-                return range(new_start, new_start);
-            return range(new_start, new_end, m_step);
+            constexpr std::size_t lanes = _Ops::bytes / sizeof(double);
+            double initial[lanes];
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+                initial[lane] = static_cast<double>(first + static_cast<std::ptrdiff_t>(lane));
+            typename _Ops::dvec index = _Ops::dload(initial);
+            const typename _Ops::dvec increment = _Ops::dset(static_cast<double>(lanes));
+            const typename _Ops::dvec vstart = _Ops::dset(start);
+            const typename _Ops::dvec vstep = _Ops::dset(step);
+            std::size_t i = 0;
+            for (; i + lanes <= count; i += lanes)
+            {
+                _Ops::dstore(out + i, _Ops::dmuladd(index, vstep, vstart));
+                index = _Ops::dadd(index, increment);
+            }
+            return i;
         }
+#endif // defined(_NPS_SSE2)
 
-        _NPS_NODISCARD constexpr circular_range<_Ty> circular(long long count = 0) const noexcept
+        // Writes the elements with indices [first, first + count) of a progression to out.
+        template <class _Ty, class _Sty>
+        inline void fill_progression(_Ty* out, std::size_t count, _Ty start, _Sty step, std::ptrdiff_t first = 0) noexcept
         {
-            return circular_range<_Ty>(m_start, m_end, m_step, count);
+            std::size_t done = 0;
+#if defined(_NPS_SSE2)
+            if constexpr (std::is_same_v<_Ty, float>)
+                done = fill_float_lanes<simd_wide_ops>(out, count, start, step, first);
+            else if constexpr (std::is_same_v<_Ty, double>)
+                done = fill_double_lanes<simd_wide_ops>(out, count, start, step, first);
+            else if constexpr (std::is_integral_v<_Ty> && !std::is_same_v<_Ty, bool>)
+            {
+                if constexpr (sizeof(_Ty) >= 4)
+                    done = fill_integral_lanes<simd_wide_ops>(out, count, start, step, first);
+                else
+                    done = fill_integral_lanes<simd_narrow_ops>(out, count, start, step, first);
+            }
+#endif // defined(_NPS_SSE2)
+            for (std::size_t i = done; i < count; ++i)
+                out[i] = progression_value(start, step, first + static_cast<std::ptrdiff_t>(i));
         }
 
-        _NPS_NODISCARD constexpr patterned_range<_Ty> patterned(_Ty(*pattern_fun)(_Ty)) const noexcept
-        {
-            return patterned_range<_Ty>(m_start, m_end, pattern_fun);
-        }
+        // Output iterators over contiguous writable _Ty storage, which can be filled through a raw pointer.
+        template <class _Ty, class _OutIt>
+        constexpr bool is_contiguous_output_v =
+#if defined(__cpp_lib_concepts)
+            std::contiguous_iterator<_OutIt> && std::is_same_v<std::iter_reference_t<_OutIt>, _Ty&>;
+#else  // defined(__cpp_lib_concepts)
+            std::is_same_v<_OutIt, _Ty*>;
+#endif // defined(__cpp_lib_concepts)
 
-        _NPS_NODISCARD constexpr range slice(size_type start_index, size_type end_index) const noexcept
+        // Branch-free membership of integral values in a progression: the offset from start in the direction of
+        // the step must be a multiple of the step (see exact_divisor) whose quotient is below the element count.
+        // A quotient below the count is never reached by a non-multiple, so the count check also covers the limit.
+        struct progression_membership
         {
-            _NPS_ASSERT(start_index <= end_index, "start_index cannot be greater than end_index");
-            _Ty new_start = nth_step(start_index + 1);
-            _Ty new_end = nth_step(end_index + 1);
-            return range(new_start, new_end, m_step);
-        }
+            unsigned long long start;
+            unsigned long long sign;        // All ones for a negative step, which negates the offset.
+            unsigned long long low_mask;    // Bits below the power of two of the step, which must be clear.
+            unsigned long long inverse;
+            unsigned long long count;
+            unsigned shift;
 
-        _NPS_NODISCARD constexpr range odd() const noexcept
+            // Index of value, or count when value is not an element.
+            unsigned long long index(unsigned long long value) const noexcept
+            {
+                const unsigned long long offset = ((value - start) ^ sign) - sign;
+                const unsigned long long quotient = (offset >> shift) * inverse;
+                return ((offset & low_mask) == 0 && quotient < count) ? quotient : count;
+            }
+        };
+
+        // Spreads the low 4 bits of bits to the low bit of 4 bytes: bit k moves to bit 8k, and no two products overlap.
+        inline std::uint32_t spread_nibble(unsigned bits) noexcept
         {
-            return range(m_start % 2 == 1 ? m_start : m_start + 1, m_end, 2);
+            return ((bits & 0xFu) * 0x00204081u) & 0x01010101u;
         }
 
-        _NPS_NODISCARD constexpr range even() const noexcept
+        // Writes the result of the membership test for every full vector of values: whether each value is an
+        // element to contains_out, or its index (-1 when absent) to index_out; exactly one of them is non-null.
+        // Returns the number of values processed; the caller finishes the tail.
+        //
+        // Values of at most 32 bits are tested on 32-bit lanes, 4 (SSE2), 8 (AVX2) or 16 (AVX-512) at a time.
+        // The test holds modulo 2^32 as well: the offsets of the elements are below 2^32 and the low 32 bits of
+        // the inverse are the inverse modulo 2^32. 64-bit values take 64-bit lanes on AVX2 and AVX-512.
+#if defined(_NPS_SSE2)
+        // 32-bit lanes of a * b modulo 2^32; SSE2 only multiplies the even lanes.
+        inline __m128i mullo_epi32(__m128i a, __m128i b) noexcept
         {
-            return range(m_start % 2 == 0 ? m_start : m_start + 1, m_end, 2);
+            const __m128i even = _mm_mul_epu32(a, b);
+            const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+            return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
         }
 
-        _NPS_NODISCARD constexpr _Ty nth_step(size_type n) const noexcept
+        // Constants of a progression_membership for 32-bit lanes, with unsigned comparisons done as signed
+        // comparisons with the sign bits flipped.
+        struct membership_lanes32
         {
-            return m_start + static_cast<_Ty>(m_step * (n - 1));
-        }
+            explicit membership_lanes32(const progression_membership& test) noexcept
+                : start(static_cast<std::uint32_t>(test.start)), sign(static_cast<std::uint32_t>(test.sign)),
+                  low_mask(static_cast<std::uint32_t>(test.low_mask)), inverse(static_cast<std::uint32_t>(test.inverse)),
+                  biased_count(static_cast<std::uint32_t>(test.count) ^ 0x80000000u), shift(test.shift) {}
 
-        _NPS_NODISCARD constexpr size_type size() const noexcept
+            std::uint32_t start;
+            std::uint32_t sign;
+            std::uint32_t low_mask;
+            std::uint32_t inverse;
+            std::uint32_t biased_count;
+            unsigned shift;
+        };
+#endif // defined(_NPS_SSE2)
+
+#if defined(_NPS_AVX512F)
+        template <class _Ty>
+        inline std::size_t membership_lanes(const progression_membership& test, const _Ty* values, std::size_t count, bool* contains_out, std::ptrdiff_t* index_out) noexcept
         {
-            size_type result = 0;
-            if (m_start == m_end) return result;
-            if constexpr (std::is_integral_v<_Ty>)
+            if constexpr (std::is_integral_v<_Ty> && sizeof(_Ty) == 8)
             {
-                result = abs((m_end - m_start) / abs(m_step));
-                return result;
+                constexpr std::size_t lanes = 8;
+                const __m512i start = _mm512_set1_epi64(static_cast<long long>(test.start));
+                const __m512i sign = _mm512_set1_epi64(static_cast<long long>(test.sign));
+                const __m512i low_mask = _mm512_set1_epi64(static_cast<long long>(test.low_mask));
+                const __m512i inverse = _mm512_set1_epi64(static_cast<long long>(test.inverse));
+                const __m512i limit = _mm512_set1_epi64(static_cast<long long>(test.count));
+                const __m512i absent = _mm512_set1_epi64(-1);
+                const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(test.shift));
+                std::size_t i = 0;
+                for (; i + lanes <= count; i += lanes)
+                {
+                    const __m512i value = _mm512_loadu_si512(values + i);
+                    const __m512i offset = _mm512_sub_epi64(_mm512_xor_si512(_mm512_sub_epi64(value, start), sign), sign);
+                    const __m512i quotient = _mm512_mullox_epi64(_mm512_srl_epi64(offset, shift), inverse);
+                    const __mmask8 found = _mm512_testn_epi64_mask(offset, low_mask) & _mm512_cmplt_epu64_mask(quotient, limit);
+                    if (index_out != nullptr)
+                        _mm512_storeu_si512(index_out + i, _mm512_mask_blend_epi64(found, absent, quotient));
+                    else
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(contains_out + i), _mm512_cvtepi64_epi8(_mm512_maskz_set1_epi64(found, 1)));
+                }
+                return i;
             }
-            else if constexpr (std::is_floating_point_v<_Ty>)
+            else if constexpr (std::is_integral_v<_Ty> && sizeof(_Ty) <= 4)
             {
-                result = ceil(abs((m_end - m_start) / m_step));
-                return result;
+                constexpr std::size_t lanes = 16;
+                const membership_lanes32 test32(test);
+                const __m512i start = _mm512_set1_epi32(static_cast<int>(test32.start));
+                const __m512i sign = _mm512_set1_epi32(static_cast<int>(test32.sign));
+                const __m512i low_mask = _mm512_set1_epi32(static_cast<int>(test32.low_mask));
+                const __m512i inverse = _mm512_set1_epi32(static_cast<int>(test32.inverse));
+                const __m512i limit = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(test.count)));
+                const __m512i absent = _mm512_set1_epi64(-1);
+                const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(test32.shift));
+                std::size_t i = 0;
+                for (; i + lanes <= count; i += lanes)
+                {
+                    __m512i value;
+                    if constexpr (sizeof(_Ty) == 4)
+                        value = _mm512_loadu_si512(values + i);
+                    else if constexpr (sizeof(_Ty) == 2)
+                    {
+                        const __m256i narrow = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+                        value = std::is_signed_v<_Ty> ? _mm512_cvtepi16_epi32(narrow) : _mm512_cvtepu16_epi32(narrow);
+                    }
+                    else
+                    {
+                        const __m128i narrow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+                        value = std::is_signed_v<_Ty> ? _mm512_cvtepi8_epi32(narrow) : _mm512_cvtepu8_epi32(narrow);
+                    }
+                    const __m512i offset = _mm512_sub_epi32(_mm512_xor_si512(_mm512_sub_epi32(value, start), sign), sign);
+                    const __m512i quotient = _mm512_mullo_epi32(_mm512_srl_epi32(offset, shift), inverse);
+                    const __mmask16 found = _mm512_testn_epi32_mask(offset, low_mask) & _mm512_cmplt_epu32_mask(quotient, limit);
+                    if (index_out != nullptr)
+                    {
+                        const __m512i low = _mm512_cvtepu32_epi64(_mm512_castsi512_si256(quotient));
+                        const __m512i high = _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(quotient, 1));
+                        _mm512_storeu_si512(index_out + i, _mm512_mask_blend_epi64(static_cast<__mmask8>(found), absent, low));
+                        _mm512_storeu_si512(index_out + i + 8, _mm512_mask_blend_epi64(static_cast<__mmask8>(found >> 8u), absent, high));
+                    }
+                    else
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(contains_out + i), _mm512_cvtepi32_epi8(_mm512_maskz_set1_epi32(found, 1)));
+                }
+                return i;
+            }
+            else
+            {
+                return 0;
             }
-            return result;
         }
-
-        template <class _Rty, class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
-        constexpr void for_each(_Rty (*func)(_Uty)) const noexcept
+#elif defined(_NPS_AVX2)
+        // 64-bit lanes of a * b modulo 2^64; AVX2 only multiplies 32-bit halves.
+        inline __m256i mullo_epi64(__m256i a, __m256i b) noexcept
         {
-            for (_Ty val : (*this))
-                (void)func(static_cast<_Uty>(val));
+            const __m256i low = _mm256_mul_epu32(a, b);
+            const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+            return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
         }
 
-        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
-        _NPS_NODISCARD iterator stop_when(bool (*predicate)(_Uty)) const noexcept
+        template <class _Ty>
+        inline std::size_t membership_lanes(const progression_membership& test, const _Ty* values, std::size_t count, bool* contains_out, std::ptrdiff_t* index_out) noexcept
         {
-            for (iterator it = begin(); it != end(); ++it)
+            if constexpr (std::is_integral_v<_Ty> && sizeof(_Ty) == 8)
             {
-                if (predicate(static_cast<_Uty>(*it)))
-                    return it;
+                constexpr std::size_t lanes = 4;
+                // Unsigned comparisons are signed comparisons with the sign bits flipped.
+                const __m256i bias = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+                const __m256i start = _mm256_set1_epi64x(static_cast<long long>(test.start));
+                const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(test.sign));
+                const __m256i low_mask = _mm256_set1_epi64x(static_cast<long long>(test.low_mask));
+                const __m256i inverse = _mm256_set1_epi64x(static_cast<long long>(test.inverse));
+                const __m256i limit = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(test.count)), bias);
+                const __m256i absent = _mm256_set1_epi64x(-1);
+                const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(test.shift));
+                std::size_t i = 0;
+                for (; i + lanes <= count; i += lanes)
+                {
+                    const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+                    const __m256i offset = _mm256_sub_epi64(_mm256_xor_si256(_mm256_sub_epi64(value, start), sign), sign);
+                    const __m256i quotient = mullo_epi64(_mm256_srl_epi64(offset, shift), inverse);
+                    const __m256i aligned = _mm256_cmpeq_epi64(_mm256_and_si256(offset, low_mask), _mm256_setzero_si256());
+                    const __m256i below = _mm256_cmpgt_epi64(limit, _mm256_xor_si256(quotient, bias));
+                    const __m256i found = _mm256_and_si256(aligned, below);
+                    if (index_out != nullptr)
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(index_out + i), _mm256_blendv_epi8(absent, quotient, found));
+                    else
+                    {
+                        const std::uint32_t bytes = spread_nibble(static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(found))));
+                        std::memcpy(contains_out + i, &bytes, sizeof(bytes));
+                    }
+                }
+                return i;
             }
-            return end();
-        }
-        
+            else if constexpr (std::is_integral_v<_Ty> && sizeof(_Ty) <= 4)
+            {
+                constexpr std::size_t lanes = 8;
+                const membership_lanes32 test32(test);
+                const __m256i bias = _mm256_set1_epi32(std::numeric_limits<int>::min());
+                const __m256i start = _mm256_set1_epi32(static_cast<int>(test32.start));
+                const __m256i sign = _mm256_set1_epi32(static_cast<int>(test32.sign));
+                const __m256i low_mask = _mm256_set1_epi32(static_cast<int>(test32.low_mask));
+                const __m256i inverse = _mm256_set1_epi32(static_cast<int>(test32.inverse));
+                const __m256i limit = _mm256_set1_epi32(static_cast<int>(test32.biased_count));
+                const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(test32.shift));
+                std::size_t i = 0;
+                for (; i + lanes <= count; i += lanes)
+                {
+                    __m256i value;
+                    if constexpr (sizeof(_Ty) == 4)
+                        value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+                    else if constexpr (sizeof(_Ty) == 2)
+                    {
+                        const __m128i narrow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+                        value = std::is_signed_v<_Ty> ? _mm256_cvtepi16_epi32(narrow) : _mm256_cvtepu16_epi32(narrow);
+                    }
+                    else
+                    {
+                        const __m128i narrow = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values + i));
+                        value = std::is_signed_v<_Ty> ? _mm256_cvtepi8_epi32(narrow) : _mm256_cvtepu8_epi32(narrow);
+                    }
+                    const __m256i offset = _mm256_sub_epi32(_mm256_xor_si256(_mm256_sub_epi32(value, start), sign), sign);
+                    const __m256i quotient = _mm256_mullo_epi32(_mm256_srl_epi32(offset, shift), inverse);
+                    const __m256i aligned = _mm256_cmpeq_epi32(_mm256_and_si256(offset, low_mask), _mm256_setzero_si256());
+                    const __m256i below = _mm256_cmpgt_epi32(limit, _mm256_xor_si256(quotient, bias));
+                    const __m256i found = _mm256_and_si256(aligned, below);
+                    if (index_out != nullptr)
+                    {
+                        // Zero-extended quotients, with every bit set in the lanes of absent values.
+                        const __m256i absent = _mm256_xor_si256(found, _mm256_set1_epi32(-1));
+                        const __m256i low = _mm256_or_si256(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(quotient)), _mm256_cvtepi32_epi64(_mm256_castsi256_si128(absent)));
+                        const __m256i high = _mm256_or_si256(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(quotient, 1)), _mm256_cvtepi32_epi64(_mm256_extracti128_si256(absent, 1)));
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(index_out + i), low);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(index_out + i + 4), high);
+                    }
+                    else
+                    {
+                        const unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(found)));
+                        const std::uint64_t bytes = spread_nibble(bits) | (static_cast<std::uint64_t>(spread_nibble(bits >> 4u)) << 32);
+                        std::memcpy(contains_out + i, &bytes, sizeof(bytes));
+                    }
+                }
+                return i;
+            }
+            else
+            {
+                return 0;
+            }
+        }
+#elif defined(_NPS_SSE2)
+        template <class _Ty>
+        inline std::size_t membership_lanes(const progression_membership& test, const _Ty* values, std::size_t count, bool* contains_out, std::ptrdiff_t* index_out) noexcept
+        {
+            if constexpr (std::is_integral_v<_Ty> && sizeof(_Ty) <= 4)
+            {
+                constexpr std::size_t lanes = 4;
+                const membership_lanes32 test32(test);
+                const __m128i bias = _mm_set1_epi32(std::numeric_limits<int>::min());
+                const __m128i start = _mm_set1_epi32(static_cast<int>(test32.start));
+                const __m128i sign = _mm_set1_epi32(static_cast<int>(test32.sign));
+                const __m128i low_mask = _mm_set1_epi32(static_cast<int>(test32.low_mask));
+                const __m128i inverse = _mm_set1_epi32(static_cast<int>(test32.inverse));
+                const __m128i limit = _mm_set1_epi32(static_cast<int>(test32.biased_count));
+                const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(test32.shift));
+                std::size_t i = 0;
+                for (; i + lanes <= count; i += lanes)
+                {
+                    // Narrow values are widened by interleaving them with their sign or with zeros.
+                    __m128i value;
+                    if constexpr (sizeof(_Ty) == 4)
+                        value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+                    else
+                    {
+                        __m128i narrow;
+                        if constexpr (sizeof(_Ty) == 2)
+                            narrow = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values + i));
+                        else
+                        {
+                            std::uint32_t bytes;
+                            std::memcpy(&bytes, values + i, sizeof(bytes));
+                            const __m128i packed = _mm_cvtsi32_si128(static_cast<int>(bytes));
+                            narrow = std::is_signed_v<_Ty> ? _mm_srai_epi16(_mm_unpacklo_epi8(packed, packed), 8) : _mm_unpacklo_epi8(packed, _mm_setzero_si128());
+                        }
+                        value = std::is_signed_v<_Ty> ? _mm_srai_epi32(_mm_unpacklo_epi16(narrow, narrow), 16) : _mm_unpacklo_epi16(narrow, _mm_setzero_si128());
+                    }
+                    const __m128i offset = _mm_sub_epi32(_mm_xor_si128(_mm_sub_epi32(value, start), sign), sign);
+                    const __m128i quotient = mullo_epi32(_mm_srl_epi32(offset, shift), inverse);
+                    const __m128i aligned = _mm_cmpeq_epi32(_mm_and_si128(offset, low_mask), _mm_setzero_si128());
+                    const __m128i below = _mm_cmplt_epi32(_mm_xor_si128(quotient, bias), limit);
+                    const __m128i found = _mm_and_si128(aligned, below);
+                    if (index_out != nullptr)
+                    {
+                        // Zero-extended quotients, with every bit set in the lanes of absent values.
+                        const __m128i absent = _mm_xor_si128(found, _mm_set1_epi32(-1));
+                        const __m128i zero = _mm_setzero_si128();
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(index_out + i), _mm_or_si128(_mm_unpacklo_epi32(quotient, zero), _mm_unpacklo_epi32(absent, absent)));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(index_out + i + 2), _mm_or_si128(_mm_unpackhi_epi32(quotient, zero), _mm_unpackhi_epi32(absent, absent)));
+                    }
+                    else
+                    {
+                        const std::uint32_t bytes = spread_nibble(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(found))));
+                        std::memcpy(contains_out + i, &bytes, sizeof(bytes));
+                    }
+                }
+                return i;
+            }
+            else
+            {
+                return 0;
+            }
+        }
+#else  // ^^^ defined(_NPS_SSE2) ^^^ / vvv !defined(_NPS_SSE2) vvv
+        template <class _Ty>
+        inline std::size_t membership_lanes(const progression_membership&, const _Ty*, std::size_t, bool*, std::ptrdiff_t*) noexcept
+        {
+            return 0;
+        }
+#endif // defined(_NPS_AVX512F)
+    }
+
+    // Predicate matching the values congruent to residue modulo modulus.
+    // range::count_if evaluates it in O(1) instead of visiting every element.
+    struct congruence
+    {
+        long long modulus;
+        long long residue;
+
+        template <class _Uty, std::enable_if_t<std::is_integral_v<_Uty>, int> = 0>
+        constexpr bool operator()(_Uty value) const noexcept
+        {
+            _NPS_ASSERT(modulus > 0, "modulus must be greater than 0");
+            const auto m = static_cast<unsigned long long>(modulus);
+            return detail::floor_mod(value, m) == detail::floor_mod(residue, m);
+        }
+    };
+
+    // Bump allocator for short-lived buffers such as materialized ranges: allocation is a pointer increment and
+    // everything is released at once by reset(), which keeps the newest block for reuse. Not thread safe.
+    class range_arena
+    {
+    public:
+        explicit range_arena(std::size_t block_size = 64 * 1024) noexcept
+            : m_next_size(block_size) {}
+
+        range_arena(const range_arena&) = delete;
+        range_arena& operator=(const range_arena&) = delete;
+
+        ~range_arena()
+        {
+            release();
+        }
+
+        void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+        {
+            // Aligning can move past the end of the block, so that is checked before measuring the space left.
+            char* result = align_up(m_cursor, alignment);
+            if (m_cursor == nullptr || result > m_limit || bytes > static_cast<std::size_t>(m_limit - result))
+            {
+                add_block(bytes + alignment);
+                result = align_up(m_cursor, alignment);
+            }
+            _NPS_ASSERT(result + bytes <= m_limit, "arena allocation exceeds its block");
+            m_cursor = result + bytes;
+            return result;
+        }
+
+        // Only the most recent allocation is given back, so a buffer that is freed right away is reused.
+        void deallocate(void* pointer, std::size_t bytes) noexcept
+        {
+            if (static_cast<char*>(pointer) + bytes == m_cursor)
+                m_cursor = static_cast<char*>(pointer);
+        }
+
+        // Frees every allocation and keeps the newest block for the next ones.
+        void reset() noexcept
+        {
+            if (m_head == nullptr)
+                return;
+            free_blocks(m_head->next);
+            m_head->next = nullptr;
+            m_cursor = data(m_head);
+            m_limit = m_cursor + m_head->size;
+        }
+
+        // Frees every allocation and returns all blocks to the heap.
+        void release() noexcept
+        {
+            free_blocks(m_head);
+            m_head = nullptr;
+            m_cursor = nullptr;
+            m_limit = nullptr;
+        }
+
+    private:
+        struct block_header
+        {
+            block_header* next;
+            std::size_t size;
+        };
+
+        static char* data(block_header* block) noexcept
+        {
+            return reinterpret_cast<char*>(block) + header_size;
+        }
+
+        static char* align_up(char* pointer, std::size_t alignment) noexcept
+        {
+            const auto address = reinterpret_cast<std::uintptr_t>(pointer);
+            return pointer + ((alignment - address % alignment) % alignment);
+        }
+
+        static void free_blocks(block_header* block) noexcept
+        {
+            while (block != nullptr)
+            {
+                block_header* next = block->next;
+                ::operator delete(block);
+                block = next;
+            }
+        }
+
+        // Blocks grow geometrically, so a long-lived arena settles on a single block after a few resets.
+        void add_block(std::size_t minimum)
+        {
+            const std::size_t size = std::max(m_next_size, minimum);
+            auto* block = static_cast<block_header*>(::operator new(header_size + size));
+            block->next = m_head;
+            block->size = size;
+            m_head = block;
+            m_cursor = data(block);
+            m_limit = m_cursor + size;
+            m_next_size = size * 2;
+        }
+
+        static constexpr std::size_t header_size = (sizeof(block_header) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+        block_header* m_head = nullptr;
+        char* m_cursor = nullptr;
+        char* m_limit = nullptr;
+        std::size_t m_next_size;
+    };
+
+    // Standard allocator drawing from a range_arena, e.g. r.to_vector(nps::arena_allocator<int>(arena)).
+    template <class _Ty>
+    class arena_allocator
+    {
+    public:
+        using value_type = _Ty;
+
+        arena_allocator(range_arena& arena) noexcept
+            : m_arena(std::addressof(arena)) {}
+
+        template <class _Uty>
+        arena_allocator(const arena_allocator<_Uty>& other) noexcept
+            : m_arena(other.arena()) {}
+
+        _NPS_NODISCARD _Ty* allocate(std::size_t count)
+        {
+            if (count > std::numeric_limits<std::size_t>::max() / sizeof(_Ty))
+                throw std::bad_array_new_length();
+            return static_cast<_Ty*>(m_arena->allocate(count * sizeof(_Ty), alignof(_Ty)));
+        }
+
+        void deallocate(_Ty* pointer, std::size_t count) noexcept
+        {
+            m_arena->deallocate(pointer, count * sizeof(_Ty));
+        }
+
+        range_arena* arena() const noexcept
+        {
+            return m_arena;
+        }
+
+        template <class _Uty>
+        bool operator==(const arena_allocator<_Uty>& right) const noexcept
+        {
+            return m_arena == right.arena();
+        }
+
+        template <class _Uty>
+        bool operator!=(const arena_allocator<_Uty>& right) const noexcept
+        {
+            return m_arena != right.arena();
+        }
+
+    private:
+        range_arena* m_arena;
+    };
+
+    namespace detail
+    {
+        // Fixed-size blocks carved from slabs of slab_nodes blocks, with a free list for reuse. The block size is
+        // taken from the first request, which for node-based containers is the node size. Not thread safe.
+        class node_pool
+        {
+        public:
+            explicit node_pool(std::size_t slab_nodes) noexcept
+                : m_slab_nodes(std::max<std::size_t>(slab_nodes, 1)) {}
+
+            node_pool(const node_pool&) = delete;
+            node_pool& operator=(const node_pool&) = delete;
+
+            ~node_pool()
+            {
+                while (m_slabs != nullptr)
+                {
+                    slab* next = m_slabs->next;
+                    ::operator delete(m_slabs);
+                    m_slabs = next;
+                }
+            }
+
+            // Whether blocks of this size and alignment come from the pool.
+            bool serves(std::size_t size, std::size_t alignment) noexcept
+            {
+                if (alignment > alignof(std::max_align_t))
+                    return false;
+                const std::size_t rounded = round_size(size, alignment);
+                if (m_node_size == 0)
+                    m_node_size = rounded;
+                return rounded == m_node_size;
+            }
+
+            void* allocate()
+            {
+                if (m_free != nullptr)
+                {
+                    free_node* node = m_free;
+                    m_free = node->next;
+                    return node;
+                }
+                if (m_cursor == m_limit)
+                    add_slab();
+                void* result = m_cursor;
+                m_cursor += m_node_size;
+                return result;
+            }
+
+            void deallocate(void* pointer) noexcept
+            {
+                auto* node = static_cast<free_node*>(pointer);
+                node->next = m_free;
+                m_free = node;
+            }
+
+        private:
+            struct free_node
+            {
+                free_node* next;
+            };
+
+            struct slab
+            {
+                slab* next;
+            };
+
+            static constexpr std::size_t header_size = (sizeof(slab) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+            static std::size_t round_size(std::size_t size, std::size_t alignment) noexcept
+            {
+                const std::size_t granule = std::max(alignment, alignof(free_node));
+                return (std::max(size, sizeof(free_node)) + granule - 1) / granule * granule;
+            }
+
+            void add_slab()
+            {
+                auto* block = static_cast<slab*>(::operator new(header_size + m_slab_nodes * m_node_size));
+                block->next = m_slabs;
+                m_slabs = block;
+                m_cursor = reinterpret_cast<char*>(block) + header_size;
+                m_limit = m_cursor + m_slab_nodes * m_node_size;
+            }
+
+            std::size_t m_slab_nodes;
+            std::size_t m_node_size = 0;
+            slab* m_slabs = nullptr;
+            free_node* m_free = nullptr;
+            char* m_cursor = nullptr;
+            char* m_limit = nullptr;
+        };
+    }
+
+    // Allocator for node-based containers such as std::list: nodes come from shared slabs of slab_nodes nodes,
+    // so building a list costs one heap allocation per slab instead of one per element. Copies share the pool,
+    // so lists built with copies of one allocator can be spliced into each other in O(1). Not thread safe.
+    template <class _Ty>
+    class node_pool_allocator
+    {
+    public:
+        using value_type                             = _Ty;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap            = std::true_type;
+
+        explicit node_pool_allocator(std::size_t slab_nodes = 1024)
+            : m_pool(std::make_shared<detail::node_pool>(slab_nodes)) {}
+
+        template <class _Uty>
+        node_pool_allocator(const node_pool_allocator<_Uty>& other) noexcept
+            : m_pool(other.pool()) {}
+
+        _NPS_NODISCARD _Ty* allocate(std::size_t count)
+        {
+            if (count == 1 && m_pool->serves(sizeof(_Ty), alignof(_Ty)))
+                return static_cast<_Ty*>(m_pool->allocate());
+            if (count > std::numeric_limits<std::size_t>::max() / sizeof(_Ty))
+                throw std::bad_array_new_length();
+            return static_cast<_Ty*>(::operator new(count * sizeof(_Ty)));
+        }
+
+        void deallocate(_Ty* pointer, std::size_t count) noexcept
+        {
+            if (count == 1 && m_pool->serves(sizeof(_Ty), alignof(_Ty)))
+                m_pool->deallocate(pointer);
+            else
+                ::operator delete(pointer);
+        }
+
+        const std::shared_ptr<detail::node_pool>& pool() const noexcept
+        {
+            return m_pool;
+        }
+
+        template <class _Uty>
+        bool operator==(const node_pool_allocator<_Uty>& right) const noexcept
+        {
+            return m_pool == right.pool();
+        }
+
+        template <class _Uty>
+        bool operator!=(const node_pool_allocator<_Uty>& right) const noexcept
+        {
+            return m_pool != right.pool();
+        }
+
+    private:
+        std::shared_ptr<detail::node_pool> m_pool;
+    };
+
+    template <class _Ty, class _Sty, std::enable_if_t<std::is_arithmetic_v<_Ty>&& std::is_arithmetic_v<_Sty>, int> = 0>
+    class range_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = _Ty;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = _Ty;
+
+        _NPS_CONSTEXPR17 range_iterator() = default;
+
+        // The iterator keeps the first value, the step and the current index, so every
+        // movement and distance is a single integer operation. Integral iterators also carry the
+        // current value and add the step on increments, so a loop needs no multiplication per element;
+        // floating values are always computed from the index, which keeps them exact.
+        _NPS_CONSTEXPR17 range_iterator(_Ty start, _Sty step, difference_type index = 0)
+            : m_start(start), m_step(step), m_index(index), m_value(detail::progression_value(start, step, index)) {}
+
+        _NPS_CONSTEXPR17 _Ty operator*() const
+        {
+            if constexpr (std::is_integral_v<_Ty>)
+                return m_value;
+            else
+                return detail::progression_value(m_start, m_step, m_index);
+        }
+
+        _NPS_CONSTEXPR17 range_iterator& operator++()
+        {
+            ++m_index;
+            if constexpr (std::is_integral_v<_Ty>)
+                m_value = detail::progression_value(m_value, m_step, 1);
+            return (*this);
+        }
+
+        _NPS_CONSTEXPR17 range_iterator operator++(int)
+        {
+            range_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        _NPS_CONSTEXPR17 range_iterator& operator--()
+        {
+            --m_index;
+            if constexpr (std::is_integral_v<_Ty>)
+                m_value = detail::progression_value(m_value, m_step, -1);
+            return (*this);
+        }
+
+        _NPS_CONSTEXPR17 range_iterator operator--(int)
+        {
+            range_iterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        _NPS_CONSTEXPR17 range_iterator& operator+=(difference_type n)
+        {
+            m_index += n;
+            m_value = detail::progression_value(m_start, m_step, m_index);
+            return (*this);
+        }
+
+        _NPS_CONSTEXPR17 range_iterator& operator-=(difference_type n)
+        {
+            return (*this) += -n;
+        }
+
+        _NPS_CONSTEXPR17 range_iterator operator+(difference_type n) const
+        {
+            return range_iterator(m_start, m_step, m_index + n);
+        }
+
+        _NPS_CONSTEXPR17 range_iterator operator-(difference_type n) const
+        {
+            return range_iterator(m_start, m_step, m_index - n);
+        }
+
+        friend _NPS_CONSTEXPR17 range_iterator operator+(difference_type n, const range_iterator& it)
+        {
+            return it + n;
+        }
+
+        _NPS_CONSTEXPR17 difference_type operator-(const range_iterator& right) const
+        {
+            return m_index - right.m_index;
+        }
+
+        _NPS_CONSTEXPR17 _Ty operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        _NPS_CONSTEXPR17 bool operator==(const range_iterator& right) const
+        {
+            return m_index == right.m_index;
+        }
+
+        _NPS_CONSTEXPR17 bool operator!=(const range_iterator& right) const
+        {
+            return !this->operator==(right);
+        }
+
+        _NPS_CONSTEXPR17 bool operator<(const range_iterator& right) const
+        {
+            return m_index < right.m_index;
+        }
+
+        _NPS_CONSTEXPR17 bool operator>(const range_iterator& right) const
+        {
+            return right < *this;
+        }
+
+        _NPS_CONSTEXPR17 bool operator<=(const range_iterator& right) const
+        {
+            return !(right < *this);
+        }
+
+        _NPS_CONSTEXPR17 bool operator>=(const range_iterator& right) const
+        {
+            return !(*this < right);
+        }
+
+    private:
+        _Ty m_start;                // First value of the range.
+        _Sty m_step;                // Step value for iteration.
+        difference_type m_index;    // Number of steps taken from m_start.
+        _Ty m_value;                // Element at m_index, maintained for integral types.
+    };
+
+    template <class _Ty, class _Sty>
+    class circular_range_iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = _Ty;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = _Ty;
+
+        circular_range_iterator() = default;
+
+        circular_range_iterator(_Ty start, _Ty end, _Sty step, long long count = 0)
+            : m_value(start), m_step(step), m_start(start), m_end(end), m_max(count), m_count(0) {}
+
+        _NPS_CONSTEXPR17 _Ty operator*() const
+        {
+            return m_value;
+        }
+
+        circular_range_iterator& operator++() noexcept
+        {
+            m_value += static_cast<_Ty>(m_step);
+            if(m_step > 0 && m_value >= m_end)
+                m_value = m_start;
+            else if(m_step < 0 && m_value <= m_end)
+                m_value = m_start;
+            if (m_max)
+                m_count++;
+            return *this;
+        }
+
+        circular_range_iterator operator++(int) noexcept
+        {
+            circular_range_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        _NPS_CONSTEXPR17 bool operator==(const circular_range_iterator& right) const
+        {
+            return m_max == right.m_max && m_max == m_count && m_max != 0;
+        }
+
+        _NPS_CONSTEXPR17 bool operator!=(const circular_range_iterator& right) const
+        {
+            return !this->operator==(right);
+        }
+
+    private:
+        _Ty m_value; // Current value in the range.
+        _Sty m_step; // Step value for iteration.
+        _Ty m_start; // Beginning of the circular range.
+        _Ty m_end;   // End of the circular range.
+        long long m_max;
+        long long m_count;
+    };
+
+    namespace detail
+    {
+        // Default pattern of patterned_range: the next value.
+        template <class _Ty>
+        constexpr _Ty next_value(_Ty value) noexcept
+        {
+            return static_cast<_Ty>(value + 1);
+        }
+
+        // Pattern used when none is given: next_value for function pointers and type-erased patterns,
+        // a default-constructed functor otherwise.
+        template <class _Ty, class _Fn>
+        constexpr _Fn default_pattern()
+            noexcept(std::is_constructible_v<_Fn, _Ty(*)(_Ty)> ? std::is_nothrow_constructible_v<_Fn, _Ty(*)(_Ty)> : std::is_nothrow_default_constructible_v<_Fn>)
+        {
+            if constexpr (std::is_constructible_v<_Fn, _Ty(*)(_Ty)>)
+                return _Fn(&next_value<_Ty>);
+            else
+                return _Fn{};
+        }
+
+        // Holds a pattern callable by value. Lambdas are neither default constructible nor assignable, so the
+        // callable is kept in an optional and rebuilt on assignment, which keeps iterators regular.
+        template <class _Fn>
+        class pattern_holder
+        {
+        public:
+            constexpr pattern_holder() = default;
+
+            constexpr explicit pattern_holder(_Fn func) noexcept(std::is_nothrow_move_constructible_v<_Fn>)
+                : m_func(std::move(func)) {}
+
+            constexpr pattern_holder(const pattern_holder&) = default;
+
+            constexpr pattern_holder& operator=(const pattern_holder& right) noexcept(std::is_nothrow_copy_constructible_v<_Fn>)
+            {
+                if (this != std::addressof(right))
+                {
+                    if (right.m_func)
+                        m_func.emplace(*right.m_func);
+                    else
+                        m_func.reset();
+                }
+                return *this;
+            }
+
+            template <class _Ty>
+            constexpr _Ty operator()(_Ty value)
+            {
+                return static_cast<_Ty>((*m_func)(value));
+            }
+
+        private:
+            std::optional<_Fn> m_func;
+        };
+    }
+
+    template <class _Ty, class _Sty, class _Fn>
+    class patterned_range_iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = _Ty;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = _Ty;
+
+        patterned_range_iterator() = default;
+
+        constexpr patterned_range_iterator(_Ty start, _Sty step, const detail::pattern_holder<_Fn>& pattern_func) noexcept(std::is_nothrow_copy_constructible_v<_Fn>)
+            : m_value(start), m_step(step), m_pattern_func(pattern_func) {}
+
+        _NPS_CONSTEXPR17 _Ty operator*() const
+        {
+            return m_value;
+        }
+
+        patterned_range_iterator& operator++()
+        {
+            m_value = m_pattern_func(m_value);
+            return (*this);
+        }
+
+        patterned_range_iterator operator++(int)
+        {
+            patterned_range_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        // Iteration ends once the value reaches or passes the end value in the direction of the range.
+        _NPS_CONSTEXPR17 bool operator==(const patterned_range_iterator& right) const
+        {
+            return (m_step > 0) ? (m_value >= right.m_value) : (m_value <= right.m_value);
+        }
+
+        _NPS_CONSTEXPR17 bool operator!=(const patterned_range_iterator& right) const
+        {
+            return !this->operator==(right);
+        }
+    private:
+        _Ty m_value{}; // Current value in the range.
+        _Sty m_step{}; // Direction of the pattern.
+        detail::pattern_holder<_Fn> m_pattern_func; // Called by value, so the pattern is inlined into the loop.
+    };
+
+    template <class _Ty = int, std::enable_if_t<std::is_arithmetic_v<_Ty>, int> = 0>
+    class circular_range
+    {
+    public:
+        using range_type = _Ty;
+        using step_type = std::conditional_t<std::is_integral_v<_Ty>, long long, _Ty>;
+        using size_type = step_type;
+        using iterator = circular_range_iterator<_Ty, step_type>;
+
+        constexpr circular_range() = default;
+
+        constexpr circular_range(_Ty end, long long count = 0)
+        {
+            reset(0, end, 1, count);
+        }
+
+        constexpr circular_range(_Ty start, _Ty end, step_type step, long long count = 0)
+        {
+            reset(start, end, step, count);
+        }
+
+        constexpr void reset(_Ty start, _Ty end, step_type step = 1, long long count = 0) noexcept
+        {
+#ifdef _DEBUG
+            _NPS_ASSERT(step != 0, "step cannot be equal to 0");
+#else 
+            if (step == 0)
+                step = 1;
+#endif // _DEBUG
+
+            m_count = count;
+            m_start = start;
+            m_end = end;
+            if (start <= end)
+                m_step = std::abs(step);
+            else
+            {
+                if (step > 0)
+                    m_step = step * (-1);
+                else
+                    m_step = step;
+            }
+        }
+
+        _NPS_NODISCARD constexpr iterator begin() const noexcept
+        {
+            return iterator(m_start, m_end, m_step, m_count);
+        }
+
+        _NPS_NODISCARD constexpr iterator end() const noexcept
+        {
+            return iterator(m_end, m_end, m_step, m_count);
+        }
+    private:
+        _Ty m_start;    // Start value of the range.
+        _Ty m_end;      // End value of the range.
+        step_type m_step; // Step value for iteration.
+        long long m_count;
+    };
+
+    // Range whose values follow a pattern: each value is pattern(previous) until the end value is reached or passed.
+    // The pattern is stored by value, so lambdas and stateful functors are called directly and inlined. The default
+    // _Fn is a function pointer; any_patterned_range erases the pattern type for use across ABI boundaries.
+    template <class _Ty = int, class _Fn = _Ty(*)(_Ty), std::enable_if_t<std::is_arithmetic_v<_Ty>, int> = 0>
+    class patterned_range
+    {
+    public:
+        using range_type = _Ty;
+        using step_type = std::conditional_t<std::is_integral_v<_Ty>, long long, _Ty>;
+        using size_type = step_type;
+        using pattern_type = _Fn;
+        using iterator = patterned_range_iterator<_Ty, step_type, _Fn>;
+
+        constexpr patterned_range() = default;
+
+        constexpr patterned_range(_Ty end, _Fn pattern_fun = detail::default_pattern<_Ty, _Fn>())
+            : patterned_range(0, end, std::move(pattern_fun)) {}
+
+        constexpr patterned_range(_Ty start, _Ty end, _Fn pattern_fun = detail::default_pattern<_Ty, _Fn>())
+            : m_start(start), m_end(end), m_negative(start > end), m_pattern_fun(std::move(pattern_fun)) {}
+
+        constexpr void reset(_Ty start, _Ty end, _Fn pattern_fun = detail::default_pattern<_Ty, _Fn>())
+            noexcept(std::is_nothrow_move_constructible_v<_Fn> && std::is_nothrow_copy_constructible_v<_Fn>)
+        {
+            m_start = start;
+            m_end = end;
+            m_negative = (start > end);
+            m_pattern_fun = detail::pattern_holder<_Fn>(std::move(pattern_fun));
+        }
+
+        _NPS_NODISCARD constexpr iterator begin() const noexcept(std::is_nothrow_copy_constructible_v<_Fn>)
+        {
+            return iterator(m_start, m_negative ? static_cast<step_type>(-1) : static_cast<step_type>(1), m_pattern_fun);
+        }
+
+        _NPS_NODISCARD constexpr iterator end() const noexcept(std::is_nothrow_copy_constructible_v<_Fn>)
+        {
+            return iterator(m_end, m_negative ? static_cast<step_type>(-1) : static_cast<step_type>(1), m_pattern_fun);
+        }
+    private:
+        _Ty m_start{};
+        _Ty m_end{};
+        bool m_negative = false;
+        detail::pattern_holder<_Fn> m_pattern_fun;
+    };
+
+    template <class _Ty, class _Fn, std::enable_if_t<!std::is_arithmetic_v<_Fn>, int> = 0>
+    patterned_range(_Ty, _Fn) -> patterned_range<_Ty, _Fn>;
+
+    template <class _Ty, class _Fn>
+    patterned_range(_Ty, _Ty, _Fn) -> patterned_range<_Ty, _Fn>;
+
+    // Patterned range with a type-erased pattern, for interfaces that cannot be templates.
+    template <class _Ty = int>
+    using any_patterned_range = patterned_range<_Ty, std::function<_Ty(_Ty)>>;
+
+    template <class _Ty, std::enable_if_t<std::is_integral_v<_Ty>, int> = 0>
+    class range_set;
+
+    template <class _Ty = int, std::enable_if_t<std::is_arithmetic_v<_Ty>, int> = 0>
+    class range
+    {
+    public:
+        using range_type    = _Ty;
+        using step_type     = std::conditional_t<std::is_integral_v<_Ty>, long long, _Ty>;
+        using size_type     = step_type;
+        using sum_type      = std::conditional_t<std::is_floating_point_v<_Ty>, _Ty, std::conditional_t<std::is_signed_v<_Ty>, long long, unsigned long long>>;
+        using iterator      = range_iterator<_Ty, step_type>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+
+        constexpr range() = default;
+
+        constexpr range(_Ty end)
+        {
+            reset(0, end);
+        }
+
+        constexpr range(_Ty start, _Ty end, step_type step = 1)
+        {
+            reset(start, end, step);
+        }
+
+        constexpr range reset(_Ty start, _Ty end, step_type step = 1) noexcept
+        {
+#ifdef _DEBUG
+            _NPS_ASSERT(step != 0, "step cannot be equal to 0");
+#else 
+            if (step == 0)
+                step = 1;
+#endif // _DEBUG
+            m_start = start;
+            m_end = end;
+            if (start <= end)
+                m_step = (step < 0) ? -step : step;
+            else
+            {
+                if (step > 0)
+                    m_step = step * (-1);
+                else
+                    m_step = step;
+            }
+
+            if (m_start == m_end)
+                m_step = 0;
+
+            m_count = compute_count();
+            if constexpr (std::is_integral_v<_Ty>)
+                m_divisor = detail::exact_divisor(m_step < 0 ? 0ULL - static_cast<unsigned long long>(m_step) : static_cast<unsigned long long>(m_step));
+            else
+                m_divisor = detail::reciprocal_divisor<_Ty>(m_step);
+            return *this;
+        }
+
+        _NPS_NODISCARD constexpr range step(step_type new_step) const noexcept
+        {
+            return range(m_start, m_end, new_step);
+        }
+
+        _NPS_NODISCARD constexpr range reverse() const noexcept
+        {
+            if (m_step < 0)
+            {
+                return range(m_end + 1, m_start + 1, -m_step);
+            }
+            return range(m_end - 1, m_start - 1, -m_step);
+        }
+
+        _NPS_NODISCARD constexpr range scale(_Ty factor) const noexcept
+        {
+            return range(m_start * factor, m_end * factor, m_step * factor);
+        }
+
+        // Elements common to both ranges, in the direction of this range. For integral ranges the result is exact
+        // for any steps and directions: the common elements are those of this range at the indices solving
+        // start + i * step = other.start (mod other.step), every lcm / |step| indices, within the other's bounds.
+        _NPS_NODISCARD constexpr range intersection(const range& other) const noexcept
+        {
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                const std::ptrdiff_t count = element_count();
+                const std::ptrdiff_t other_count = other.element_count();
+                if (count == 0 || other_count == 0)
+                    return range(m_start, m_start);
+                if (count == 1 || other_count == 1)
+                {
+                    const _Ty value = (count == 1) ? m_start : other.m_start;
+                    if (!contains(value) || !other.contains(value))
+                        return range(m_start, m_start);
+                    return range(value, (m_step > 0) ? value + 1 : value - 1);
+                }
+                const unsigned long long stride = (m_step < 0) ? 0ULL - static_cast<unsigned long long>(m_step) : static_cast<unsigned long long>(m_step);
+                const unsigned long long modulus = (other.m_step < 0) ? 0ULL - static_cast<unsigned long long>(other.m_step) : static_cast<unsigned long long>(other.m_step);
+                const detail::congruence_solution solution = detail::solve_index_congruence(m_start, m_step, modulus, detail::floor_mod(other.m_start, modulus));
+                if (!solution.exists)
+                    return range(m_start, m_start);
+
+                // Indices of this range whose elements lie within the bounds of other: from the bound met first in
+                // the direction of the step to the bound met last.
+                const _Ty near_bound = (m_step > 0) ? other.min() : other.max();
+                const _Ty far_bound = (m_step > 0) ? other.max() : other.min();
+                const auto ahead = [this](_Ty value) { return (m_step > 0) ? (value >= m_start) : (value <= m_start); };
+                const auto distance = [this](_Ty value)
+                {
+                    return (m_step > 0) ? static_cast<unsigned long long>(value) - static_cast<unsigned long long>(m_start)
+                                        : static_cast<unsigned long long>(m_start) - static_cast<unsigned long long>(value);
+                };
+                if (!ahead(far_bound))
+                    return range(m_start, m_start);
+                const unsigned long long near_distance = ahead(near_bound) ? distance(near_bound) : 0;
+                const unsigned long long low = (near_distance == 0) ? 0 : (near_distance - 1) / stride + 1;
+                const unsigned long long high = std::min(distance(far_bound) / stride, static_cast<unsigned long long>(count) - 1);
+                if (low > high)
+                    return range(m_start, m_start);
+                return every_nth(low + detail::sub_mod(solution.first, low % solution.period, solution.period), solution.period, high);
+            }
+            else
+            {
+                _Ty new_start = std::max(m_start, other.m_start);
+                _Ty new_end = std::min(m_end, other.m_end);
+                if (new_start >= new_end)
+                    return range(new_start, new_start);
+                return range(new_start, new_end, m_step);
+            }
+        }
+
+        // Union and difference of integral ranges, which are not progressions in general. The common elements are
+        // found in O(log step) as for intersection, so the cost is O(log step) plus one step per interval of the result.
+        template <class _Uty = _Ty, std::enable_if_t<std::is_integral_v<_Uty>, int> = 0>
+        _NPS_NODISCARD range_set<_Uty> unite(const range& other) const
+        {
+            range_set<_Uty> result(*this);
+            result.insert(other);
+            return result;
+        }
+
+        template <class _Uty = _Ty, std::enable_if_t<std::is_integral_v<_Uty>, int> = 0>
+        _NPS_NODISCARD range_set<_Uty> difference(const range& other) const
+        {
+            range_set<_Uty> result(*this);
+            result.erase(other);
+            return result;
+        }
+
+        _NPS_NODISCARD constexpr circular_range<_Ty> circular(long long count = 0) const noexcept
+        {
+            return circular_range<_Ty>(m_start, m_end, m_step, count);
+        }
+
+        _NPS_NODISCARD patterned_range<_Ty> patterned(_Ty(*pattern_fun)(_Ty)) const
+        {
+            return patterned_range<_Ty>(m_start, m_end, pattern_fun);
+        }
+
+        // Patterned range over the same bounds calling func by value, e.g. patterned([](int v) { return v * 2 + 1; }).
+        template <class _Fn>
+        _NPS_NODISCARD patterned_range<_Ty, std::decay_t<_Fn>> patterned(_Fn&& func) const
+        {
+            return patterned_range<_Ty, std::decay_t<_Fn>>(m_start, m_end, std::forward<_Fn>(func));
+        }
+
+        _NPS_NODISCARD constexpr range slice(size_type start_index, size_type end_index) const noexcept
+        {
+            _NPS_ASSERT(start_index <= end_index, "start_index cannot be greater than end_index");
+            // The element at index count is one step past the last one and can wrap for narrow types
+            // (nd_range::split slices up to the count), so indices from the count on map to m_end.
+            const auto count = static_cast<size_type>(element_count());
+            _Ty new_start = (start_index < count) ? nth_step(start_index + 1) : m_end;
+            _Ty new_end = (end_index < count) ? nth_step(end_index + 1) : m_end;
+            return range(new_start, new_end, m_step);
+        }
+
+        // Elements congruent to residue modulo modulus, in O(log modulus): they are the elements at the indices
+        // solving start + i * step = residue (mod modulus), which repeat every modulus / gcd(step, modulus) indices.
+        template <class _Uty = _Ty, std::enable_if_t<std::is_integral_v<_Uty>, int> = 0>
+        _NPS_NODISCARD constexpr range congruent(long long modulus, long long residue) const noexcept
+        {
+            _NPS_ASSERT(modulus > 0, "modulus must be greater than 0");
+            const std::ptrdiff_t count = element_count();
+            const auto m = static_cast<unsigned long long>(modulus);
+            if (count == 0)
+                return range(m_start, m_start);
+            const detail::congruence_solution solution = detail::solve_index_congruence(m_start, m_step, m, detail::floor_mod(residue, m));
+            if (!solution.exists)
+                return range(m_start, m_start);
+            return every_nth(solution.first, solution.period, static_cast<unsigned long long>(count) - 1);
+        }
+
+        // The modulus ranges of the elements congruent to 0, 1, ..., modulus - 1, e.g. one shard per worker.
+        template <class _Uty = _Ty, std::enable_if_t<std::is_integral_v<_Uty>, int> = 0>
+        _NPS_NODISCARD std::vector<range> partition_by_modulus(long long modulus) const
+        {
+            _NPS_ASSERT(modulus > 0, "modulus must be greater than 0");
+            std::vector<range> result;
+            result.reserve(static_cast<std::size_t>(modulus));
+            for (long long residue = 0; residue < modulus; ++residue)
+                result.push_back(congruent(modulus, residue));
+            return result;
+        }
+
+        template <class _Uty = _Ty, std::enable_if_t<std::is_integral_v<_Uty>, int> = 0>
+        _NPS_NODISCARD constexpr range odd() const noexcept
+        {
+            return congruent(2, 1);
+        }
+
+        template <class _Uty = _Ty, std::enable_if_t<std::is_integral_v<_Uty>, int> = 0>
+        _NPS_NODISCARD constexpr range even() const noexcept
+        {
+            return congruent(2, 0);
+        }
+
+        _NPS_NODISCARD constexpr _Ty nth_step(size_type n) const noexcept
+        {
+            return m_start + static_cast<_Ty>(m_step * (n - 1));
+        }
+
+        _NPS_NODISCARD constexpr size_type size() const noexcept
+        {
+            return static_cast<size_type>(element_count());
+        }
+
+        // Computed from the closed form rather than through the iterators, whose operators are not constexpr
+        // everywhere, so front(), back(), min() and max() are constant expressions.
+        _NPS_NODISCARD constexpr _Ty front() const noexcept
+        {
+            _NPS_ASSERT(!empty(), "range cannot be empty");
+            return m_start;
+        }
+
+        _NPS_NODISCARD constexpr _Ty back() const noexcept
+        {
+            _NPS_ASSERT(!empty(), "range cannot be empty");
+            return detail::progression_value(m_start, m_step, element_count() - 1);
+        }
+
+        _NPS_NODISCARD constexpr _Ty min() const noexcept
+        {
+            return (m_step < 0) ? back() : front();
+        }
+
+        _NPS_NODISCARD constexpr _Ty max() const noexcept
+        {
+            return (m_step < 0) ? front() : back();
+        }
+
+        // Sum of all elements in O(1). Integral sums are evaluated modulo 2^64 with the divisions
+        // applied before the multiplications, so the result is exact whenever it fits in sum_type.
+        _NPS_NODISCARD constexpr sum_type sum() const noexcept
+        {
+            const auto count = static_cast<unsigned long long>(element_count());
+            if (count == 0)
+                return sum_type{};
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                const auto first = static_cast<unsigned long long>(m_start);
+                const auto step = static_cast<unsigned long long>(m_step);
+                return static_cast<sum_type>(count * first + step * detail::sum_of_indices(count));
+            }
+            else
+            {
+                const long double n = static_cast<long double>(count);
+                return static_cast<sum_type>(n * (static_cast<long double>(front()) + static_cast<long double>(back())) / 2);
+            }
+        }
+
+        // Sum of the squares of all elements in O(1), with the same exactness guarantees as sum().
+        _NPS_NODISCARD constexpr sum_type sum_of_squares() const noexcept
+        {
+            const auto count = static_cast<unsigned long long>(element_count());
+            if (count == 0)
+                return sum_type{};
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                const auto first = static_cast<unsigned long long>(m_start);
+                const auto step = static_cast<unsigned long long>(m_step);
+                return static_cast<sum_type>(count * first * first
+                    + 2 * first * step * detail::sum_of_indices(count)
+                    + step * step * detail::sum_of_squared_indices(count));
+            }
+            else
+            {
+                const long double n = static_cast<long double>(count);
+                const long double first = static_cast<long double>(m_start);
+                const long double step = static_cast<long double>(m_step);
+                const long double indices = n * (n - 1) / 2;
+                const long double squared_indices = (n - 1) * n * (2 * n - 1) / 6;
+                return static_cast<sum_type>(n * first * first + 2 * first * step * indices + step * step * squared_indices);
+            }
+        }
+
+        // The algorithms below accept any callable, so lambdas (capturing or not) and function objects are inlined
+        // into a counted loop over the element indices. The function pointer overloads convert each element to the
+        // pointer's parameter type first.
+        template <class _Fn>
+        constexpr void for_each(_Fn&& func) const
+        {
+            const std::ptrdiff_t count = element_count();
+            for (std::ptrdiff_t i = 0; i < count; ++i)
+                (void)func(detail::progression_value(m_start, m_step, i));
+        }
+
+        template <class _Rty, class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
+        constexpr void for_each(_Rty (*func)(_Uty)) const noexcept
+        {
+            for_each([func](_Ty val) { return func(static_cast<_Uty>(val)); });
+        }
+
+        // Iterator to the first element matching predicate, or end().
+        template <class _Fn>
+        _NPS_NODISCARD constexpr iterator stop_when(_Fn&& predicate) const
+        {
+            for (iterator it = begin(); it != end(); ++it)
+            {
+                if (predicate(*it))
+                    return it;
+            }
+            return end();
+        }
+
+        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
+        _NPS_NODISCARD constexpr iterator stop_when(bool (*predicate)(_Uty)) const noexcept
+        {
+            return stop_when([predicate](_Ty val) { return predicate(static_cast<_Uty>(val)); });
+        }
+
+        // Iterator to the first element not matching predicate, or end().
+        template <class _Fn>
+        _NPS_NODISCARD constexpr iterator step_while(_Fn&& predicate) const
+        {
+            iterator it = begin();
+            while (it != end() && predicate(*it))
+                ++it;
+            return it;
+        }
+
+        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
+        _NPS_NODISCARD constexpr iterator step_while(bool (*predicate)(_Uty)) const noexcept
+        {
+            return step_while([predicate](_Ty val) { return predicate(static_cast<_Uty>(val)); });
+        }
+
+        // Binary-search forms of step_while for predicates that hold for a prefix of the range and for no element
+        // after it (as std::partition_point). The elements are probed through their closed form, so the boundary is
+        // found in O(log n) calls to predicate, e.g. about 30 over 10^9 elements.
+        template <class _Fn>
+        _NPS_NODISCARD constexpr iterator partition_point(_Fn&& predicate) const
+        {
+            return begin() + partition_index(predicate, 0, element_count());
+        }
+
+        // Same result as partition_point, probing the elements at indices 0, 1, 3, 7, ... first, so a boundary k
+        // elements from the front takes O(log k) calls. Preferable when the boundary is usually near the front.
+        template <class _Fn>
+        _NPS_NODISCARD constexpr iterator gallop_partition_point(_Fn&& predicate) const
+        {
+            const std::ptrdiff_t count = element_count();
+            std::ptrdiff_t low = 0;
+            std::ptrdiff_t high = 0;
+            for (std::ptrdiff_t span = 1; high < count && predicate(detail::progression_value(m_start, m_step, high)); span *= 2)
+            {
+                low = high + 1;
+                high = (span < count - high) ? high + span : count;
+            }
+            return begin() + partition_index(predicate, low, high);
+        }
+
+        // First element x for which comp(projection(x), key) is false, for a range sorted by projection.
+        template <class _Fn, class _Key, class _Cmp = std::less<>>
+        _NPS_NODISCARD constexpr iterator lower_bound_by(_Fn&& projection, const _Key& key, _Cmp comp = {}) const
+        {
+            return partition_point([&](_Ty value) { return comp(projection(value), key); });
+        }
+
+        // First element x for which comp(key, projection(x)) is true, for a range sorted by projection.
+        template <class _Fn, class _Key, class _Cmp = std::less<>>
+        _NPS_NODISCARD constexpr iterator upper_bound_by(_Fn&& projection, const _Key& key, _Cmp comp = {}) const
+        {
+            return partition_point([&](_Ty value) { return !comp(key, projection(value)); });
+        }
+
+        template <class _Fn>
+        constexpr bool all_of(_Fn&& predicate) const
+        {
+            const std::ptrdiff_t count = element_count();
+            for (std::ptrdiff_t i = 0; i < count; ++i)
+            {
+                if (!predicate(detail::progression_value(m_start, m_step, i)))
+                    return false;
+            }
+            return true;
+        }
+
+        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
+        constexpr bool all_of(bool (*predicate)(_Uty)) const noexcept
+        {
+            return all_of([predicate](_Ty val) { return predicate(static_cast<_Uty>(val)); });
+        }
+
+        template <class _Fn>
+        constexpr bool any_of(_Fn&& predicate) const
+        {
+            const std::ptrdiff_t count = element_count();
+            for (std::ptrdiff_t i = 0; i < count; ++i)
+            {
+                if (predicate(detail::progression_value(m_start, m_step, i)))
+                    return true;
+            }
+            return false;
+        }
+
         template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
-        _NPS_NODISCARD constexpr iterator step_while(bool (*predicate)(_Uty)) const noexcept
+        constexpr bool any_of(bool (*predicate)(_Uty)) const noexcept
+        {
+            return any_of([predicate](_Ty val) { return predicate(static_cast<_Uty>(val)); });
+        }
+
+        template <class _Fn>
+        constexpr bool none_of(_Fn&& predicate) const
+        {
+            return !any_of(predicate);
+        }
+
+        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
+        constexpr bool none_of(bool (*predicate)(_Uty)) const noexcept
+        {
+            return !any_of(predicate);
+        }
+
+        template <class _Fn, std::enable_if_t<!std::is_same_v<std::decay_t<_Fn>, congruence>, int> = 0>
+        constexpr size_type count_if(_Fn&& predicate) const
+        {
+            size_type result = 0;
+            const std::ptrdiff_t count = element_count();
+            for (std::ptrdiff_t i = 0; i < count; ++i)
+            {
+                if (predicate(detail::progression_value(m_start, m_step, i)))
+                    ++result;
+            }
+            return result;
+        }
+
+        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
+        constexpr size_type count_if(bool (*predicate)(_Uty)) const noexcept
+        {
+            return count_if([predicate](_Ty val) { return predicate(static_cast<_Uty>(val)); });
+        }
+
+        // Counts the elements matching a congruence in O(1) by solving start + i * step = residue (mod modulus).
+        template <class _Uty = _Ty, std::enable_if_t<std::is_integral_v<_Uty>, int> = 0>
+        _NPS_NODISCARD constexpr size_type count_if(const congruence& predicate) const noexcept
+        {
+            _NPS_ASSERT(predicate.modulus > 0, "modulus must be greater than 0");
+            const auto modulus = static_cast<unsigned long long>(predicate.modulus);
+            const auto count = static_cast<unsigned long long>(element_count());
+            const detail::congruence_solution solution = detail::solve_index_congruence(m_start, m_step, modulus, detail::floor_mod(predicate.residue, modulus));
+            if (!solution.exists || solution.first >= count)
+                return 0;
+            return static_cast<size_type>((count - 1 - solution.first) / solution.period + 1);
+        }
+
+        // Index of value in the range, so that begin()[*index_of(value)] == value, or nullopt. O(1) and division-free:
+        // reset() stores the exact divisor of the step for integral ranges and its reciprocal for floating ones.
+        // A floating value is found only if it equals an element exactly as the iterator computes it.
+        _NPS_NODISCARD constexpr std::optional<std::ptrdiff_t> index_of(_Ty value) const noexcept
+        {
+            const std::ptrdiff_t count = element_count();
+            if (count == 0)
+                return std::nullopt;
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                // A value before the start wraps around to an offset no element can reach.
+                const unsigned long long offset = (m_step > 0)
+                    ? static_cast<unsigned long long>(value) - static_cast<unsigned long long>(m_start)
+                    : static_cast<unsigned long long>(m_start) - static_cast<unsigned long long>(value);
+                unsigned long long index = 0;
+                if (!m_divisor.divides(offset, index) || index >= static_cast<unsigned long long>(count))
+                    return std::nullopt;
+                return static_cast<std::ptrdiff_t>(index);
+            }
+            else
+            {
+                // The estimate is settled against the neighbouring elements, as in compute_count().
+                using real_type = typename divisor_type::value_type;
+                const real_type estimate = (static_cast<real_type>(value) - static_cast<real_type>(m_start)) * m_divisor.reciprocal;
+                if (!(estimate > -1 && estimate < static_cast<real_type>(count) + 1))
+                    return std::nullopt;
+                const auto nearest = static_cast<std::ptrdiff_t>(estimate + real_type(0.5));
+                const std::ptrdiff_t last = std::min(nearest + 1, count - 1);
+                for (std::ptrdiff_t index = std::max<std::ptrdiff_t>(nearest - 1, 0); index <= last; ++index)
+                {
+                    if (detail::progression_value(m_start, m_step, index) == value)
+                        return index;
+                }
+                return std::nullopt;
+            }
+        }
+
+        _NPS_NODISCARD constexpr bool contains(_Ty value) const noexcept
+        {
+            return index_of(value).has_value();
+        }
+
+        // Batch form of contains: out[i] = contains(values[i]). Integral values are tested with the same
+        // division-free test as index_of on vector lanes: up to 16 values of at most 32 bits (AVX-512) or
+        // 8 values of 64 bits per instruction.
+        void contains_batch(const _Ty* values, std::size_t count, bool* out) const noexcept
+        {
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                const detail::progression_membership test = membership();
+                const std::size_t done = detail::membership_lanes(test, values, count, out, nullptr);
+                for (const _Ty* value = values + done; value != values + count; ++value)
+                    out[value - values] = test.index(static_cast<unsigned long long>(*value)) != test.count;
+            }
+            else
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                    out[i] = index_of(values[i]).has_value();
+            }
+        }
+
+        // Batch form of index_of: out[i] is the index of values[i], or -1 when it is not an element.
+        void index_of_batch(const _Ty* values, std::size_t count, std::ptrdiff_t* out) const noexcept
+        {
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                const detail::progression_membership test = membership();
+                const std::size_t done = detail::membership_lanes(test, values, count, nullptr, out);
+                for (const _Ty* value = values + done; value != values + count; ++value)
+                {
+                    const unsigned long long index = test.index(static_cast<unsigned long long>(*value));
+                    out[value - values] = (index != test.count) ? static_cast<std::ptrdiff_t>(index) : -1;
+                }
+            }
+            else
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                    out[i] = index_of(values[i]).value_or(-1);
+            }
+        }
+
+        // Batch form of nth_step: out[i] = nth_step(steps[i]), with 1-based step numbers like nth_step.
+        void nth_step_batch(const std::ptrdiff_t* steps, std::size_t count, _Ty* out) const noexcept
+        {
+            for (std::size_t i = 0; i < count; ++i)
+                out[i] = detail::progression_value(m_start, m_step, steps[i] - 1);
+        }
+
+#if defined(__cpp_lib_span)
+        void contains_batch(std::span<const _Ty> values, std::span<bool> out) const noexcept
+        {
+            _NPS_ASSERT(out.size() >= values.size(), "out is smaller than values");
+            contains_batch(values.data(), values.size(), out.data());
+        }
+
+        void index_of_batch(std::span<const _Ty> values, std::span<std::ptrdiff_t> out) const noexcept
+        {
+            _NPS_ASSERT(out.size() >= values.size(), "out is smaller than values");
+            index_of_batch(values.data(), values.size(), out.data());
+        }
+
+        void nth_step_batch(std::span<const std::ptrdiff_t> steps, std::span<_Ty> out) const noexcept
+        {
+            _NPS_ASSERT(out.size() >= steps.size(), "out is smaller than steps");
+            nth_step_batch(steps.data(), steps.size(), out.data());
+        }
+#endif // defined(__cpp_lib_span)
+
+        constexpr bool empty() const noexcept
+        {
+            return element_count() == 0;
+        }
+
+        constexpr void swap(range& right) noexcept
+        {
+            if (std::addressof(right) != this)
+            {
+                std::swap(m_start, right.m_start);
+                std::swap(m_end, right.m_end);
+                std::swap(m_step, right.m_step);
+                std::swap(m_count, right.m_count);
+                std::swap(m_divisor, right.m_divisor);
+            }
+        }
+
+        std::vector<_Ty> to_vector() const
+        {
+            return to_vector(std::allocator<_Ty>());
+        }
+
+        // Materializes the range with the given allocator, e.g. an arena_allocator or a std::pmr::polymorphic_allocator.
+        // The storage is allocated once.
+        template <class _Alloc, std::enable_if_t<!std::is_pointer_v<_Alloc>, int> = 0>
+        std::vector<_Ty, _Alloc> to_vector(const _Alloc& alloc) const
+        {
+            // Generated in place one cache-sized block at a time: resize zeroes the block, which is still in cache
+            // when the vectorized generator overwrites it, so memory sees a single write per element.
+            constexpr std::size_t block_size = 8192;
+            const auto count = static_cast<std::size_t>(element_count());
+            std::vector<_Ty, _Alloc> result(alloc);
+            result.reserve(count);
+            for (std::size_t i = 0; i < count; i += block_size)
+            {
+                const std::size_t n = std::min(block_size, count - i);
+                result.resize(i + n);
+                detail::fill_progression(result.data() + i, n, m_start, m_step, static_cast<std::ptrdiff_t>(i));
+            }
+            return result;
+        }
+        
+        // Writes the elements with indices [first, first + capacity) to out, without allocating. Returns the number
+        // written, which is smaller than capacity at the end of the range, so a large range can be produced in chunks:
+        //   for (std::size_t i = 0, n; (n = r.fill_into(buffer, size, i)) != 0; i += n) consume(buffer, n);
+        std::size_t fill_into(_Ty* out, std::size_t capacity, std::size_t first = 0) const noexcept
+        {
+            const auto count = static_cast<std::size_t>(element_count());
+            if (first >= count)
+                return 0;
+            const std::size_t n = std::min(capacity, count - first);
+            detail::fill_progression(out, n, m_start, m_step, static_cast<std::ptrdiff_t>(first));
+            return n;
+        }
+
+#if defined(__cpp_lib_span)
+        std::size_t fill_into(std::span<_Ty> out, std::size_t first = 0) const noexcept
+        {
+            return fill_into(out.data(), out.size(), first);
+        }
+#endif // defined(__cpp_lib_span)
+
+        // Writes every element to out and returns the iterator past the last one written, like std::copy.
+        // Contiguous destinations are filled in place by the vectorized generator.
+        template <class _OutIt>
+        _OutIt copy_to(_OutIt out) const
+        {
+            const auto count = static_cast<std::size_t>(element_count());
+            if constexpr (detail::is_contiguous_output_v<_Ty, _OutIt>)
+            {
+#if defined(__cpp_lib_concepts)
+                detail::fill_progression(std::to_address(out), count, m_start, m_step);
+#else  // defined(__cpp_lib_concepts)
+                detail::fill_progression(out, count, m_start, m_step);
+#endif // defined(__cpp_lib_concepts)
+                return out + static_cast<std::ptrdiff_t>(count);
+            }
+            else
+            {
+                constexpr std::size_t block_size = 1024;
+                _Ty block[block_size];
+                for (std::size_t i = 0; i < count; i += block_size)
+                {
+                    const std::size_t n = std::min(block_size, count - i);
+                    detail::fill_progression(block, n, m_start, m_step, static_cast<std::ptrdiff_t>(i));
+                    out = std::copy(block, block + n, out);
+                }
+                return out;
+            }
+        }
+
+        // The first _Size elements as a std::array, usable in constant expressions to bake tables into read-only data:
+        //   constexpr auto offsets = nps::range(0, 64, 8).to_array<8>();
+        template <std::size_t _Size>
+        _NPS_NODISCARD constexpr std::array<_Ty, _Size> to_array() const noexcept
+        {
+            return to_array<_Size>([](_Ty value) { return value; });
+        }
+
+        // The first _Size elements transformed by func, e.g. to_array<8>([](int i) { return i * i; }).
+        template <std::size_t _Size, class _Fn>
+        _NPS_NODISCARD constexpr auto to_array(_Fn&& func) const
+        {
+            _NPS_ASSERT(static_cast<std::ptrdiff_t>(_Size) <= element_count(), "_Size cannot be greater than size()");
+            return detail::make_array<_Size>([this, &func](std::size_t index)
+            {
+                return func(detail::progression_value(m_start, m_step, static_cast<std::ptrdiff_t>(index)));
+            });
+        }
+
+        std::list<_Ty> to_list() const
+        {
+            return to_list(std::allocator<_Ty>());
+        }
+
+        template <class _Alloc, std::enable_if_t<!std::is_pointer_v<_Alloc>, int> = 0>
+        std::list<_Ty, _Alloc> to_list(const _Alloc& alloc) const
+        {
+            std::list<_Ty, _Alloc> result(alloc);
+            append_to(result);
+            return result;
+        }
+
+        // A list whose nodes come from a pool sized for the whole range, so it is built with a single allocation.
+        std::list<_Ty, node_pool_allocator<_Ty>> to_pooled_list() const
+        {
+            // One extra node for implementations that allocate the list sentinel.
+            return to_list(node_pool_allocator<_Ty>(static_cast<std::size_t>(element_count()) + 1));
+        }
+
+        // Appends the elements to list using its allocator. Lists built with copies of one node_pool_allocator
+        // share their nodes' pool, so they can then be spliced into each other in O(1).
+        template <class _Alloc>
+        void append_to(std::list<_Ty, _Alloc>& list) const
+        {
+            for (_Ty item : (*this))
+                list.emplace_back(item);
+        }
+
+#if defined(__cpp_lib_memory_resource)
+        // Materializes the range from a memory resource, e.g. a per-request std::pmr::monotonic_buffer_resource.
+        std::pmr::vector<_Ty> to_vector(std::pmr::memory_resource* resource) const
+        {
+            return to_vector(std::pmr::polymorphic_allocator<_Ty>(resource));
+        }
+
+        std::pmr::list<_Ty> to_list(std::pmr::memory_resource* resource) const
+        {
+            return to_list(std::pmr::polymorphic_allocator<_Ty>(resource));
+        }
+#endif // defined(__cpp_lib_memory_resource)
+
+        _NPS_CONSTEXPR17 bool operator==(const range& right) const noexcept
+        {
+            return m_start == right.m_start && m_end == right.m_end && m_step == right.m_step;
+        }
+
+        _NPS_CONSTEXPR17 bool operator!=(const range& right) const noexcept
+        {
+            return !(*this == right);
+        }
+
+        _NPS_NODISCARD constexpr iterator begin() const noexcept
+        {
+            return iterator(m_start, m_step);
+        }
+
+        _NPS_NODISCARD constexpr iterator end() const noexcept
+        {
+            return iterator(m_start, m_step, element_count());
+        }
+
+        _NPS_NODISCARD constexpr reverse_iterator rbegin() const noexcept
+        {
+            return reverse_iterator(end());
+        }
+
+        _NPS_NODISCARD constexpr reverse_iterator rend() const noexcept
+        {
+            return reverse_iterator(begin());
+        }
+    private:
+        using divisor_type = std::conditional_t<std::is_integral_v<_Ty>, detail::exact_divisor, detail::reciprocal_divisor<_Ty>>;
+
+        // Only integral ranges have an exact divisor; the batch lookups use index_of for floating ones.
+        detail::progression_membership membership() const noexcept
+        {
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                const unsigned long long low_mask = (1ULL << m_divisor.shift) - 1;
+                return { static_cast<unsigned long long>(m_start), (m_step < 0) ? ~0ULL : 0ULL, low_mask,
+                    m_divisor.inverse, static_cast<unsigned long long>(element_count()), m_divisor.shift };
+            }
+            else
+            {
+                return {};
+            }
+        }
+
+        // Index of the first element in [low, high) for which predicate is false, or high.
+        template <class _Fn>
+        constexpr std::ptrdiff_t partition_index(_Fn& predicate, std::ptrdiff_t low, std::ptrdiff_t high) const
+        {
+            std::ptrdiff_t count = high - low;
+            while (count > 0)
+            {
+                const std::ptrdiff_t half = count / 2;
+                if (predicate(detail::progression_value(m_start, m_step, low + half)))
+                {
+                    low += half + 1;
+                    count -= half + 1;
+                }
+                else
+                {
+                    count = half;
+                }
+            }
+            return low;
+        }
+
+        // Elements at indices first, first + period, ... up to last_index, in the direction of the range.
+        // last_index must be below the element count.
+        constexpr range every_nth(unsigned long long first, unsigned long long period, unsigned long long last_index) const noexcept
+        {
+            if (first > last_index)
+                return range(m_start, m_start);
+            const unsigned long long last = first + (last_index - first) / period * period;
+            const _Ty start = detail::progression_value(m_start, m_step, static_cast<std::ptrdiff_t>(first));
+            const _Ty back = detail::progression_value(m_start, m_step, static_cast<std::ptrdiff_t>(last));
+            if (first == last)
+                return range(start, (m_step > 0) ? back + 1 : back - 1);
+            const unsigned long long stride = (m_step < 0) ? 0ULL - static_cast<unsigned long long>(m_step) : static_cast<unsigned long long>(m_step);
+            _NPS_ASSERT(period <= static_cast<unsigned long long>(std::numeric_limits<step_type>::max()) / stride, "step does not fit in step_type");
+            const auto step = static_cast<step_type>(period * stride);
+            return range(start, (m_step > 0) ? back + 1 : back - 1, (m_step > 0) ? step : -step);
+        }
+
+        // Exact number of elements. size() converts it to size_type, which cannot hold every count for floating ranges.
+        constexpr std::ptrdiff_t element_count() const noexcept
+        {
+            return m_count;
+        }
+
+        // Computed once by reset(), so iteration runs to a known trip count and never compares values against m_end.
+        constexpr std::ptrdiff_t compute_count() const noexcept
+        {
+            if (m_start == m_end)
+                return 0;
+            if constexpr (std::is_integral_v<_Ty>)
+            {
+                return detail::integral_count(m_start, m_end, m_step);
+            }
+            else
+            {
+                // The quotient can be off by one after rounding, so it is settled against the values the
+                // iterator produces: the last element is the last computed value strictly before m_end.
+                const auto before_end = [this](std::ptrdiff_t index)
+                {
+                    const _Ty value = detail::progression_value(m_start, m_step, index);
+                    return (m_step > 0) ? (value < m_end) : (value > m_end);
+                };
+                auto count = static_cast<std::ptrdiff_t>((m_end - m_start) / m_step);
+                while (count > 0 && !before_end(count - 1))
+                    --count;
+                while (before_end(count))
+                    ++count;
+                return count;
+            }
+        }
+
+        _Ty m_start{};    // Start value of the range.
+        _Ty m_end{};      // End value of the range.
+        step_type m_step{}; // Step value for iteration.
+        std::ptrdiff_t m_count{}; // Number of elements.
+        divisor_type m_divisor{}; // Precomputed divisor of the step, used by index_of().
+    };
+
+    // Swap function for range objects.
+    // @param lhs The left-hand side range to swap.
+    // @param rhs The right-hand side range to swap.
+    template <class _Ty>
+    void swap(range<_Ty>& lhs, range<_Ty>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    // Concatenates the ranges into one list whose nodes come from a single pool sized for all of them.
+    template <class _Ty, class... _Rest>
+    std::list<_Ty, node_pool_allocator<_Ty>> make_pooled_list(const range<_Ty>& first, const _Rest&... rest)
+    {
+        const auto count = static_cast<std::size_t>((first.end() - first.begin()) + ((rest.end() - rest.begin()) + ... + 0));
+        std::list<_Ty, node_pool_allocator<_Ty>> result(node_pool_allocator<_Ty>(count + 1));
+        first.append_to(result);
+        (rest.append_to(result), ...);
+        return result;
+    }
+
+    // Set of integral values stored as sorted intervals whose hulls do not overlap: arithmetic progressions, or
+    // periodic patterns of up to 64 steps, so its memory and the cost of the set operations grow with the number
+    // of intervals rather than elements. Adjacent intervals continuing the same pattern are coalesced. contains()
+    // is a binary search, and size() is maintained by every operation. Where two intervals overlap, the result
+    // there is periodic with the least common multiple of their periods (e.g. 6 for steps 2 and 3), and is
+    // evaluated over a single period into one interval; only results with longer periods are built run by run.
+    template <class _Ty, std::enable_if_t<std::is_integral_v<_Ty>, int>>
+    class range_set
+    {
+    public:
+        using value_type = _Ty;
+        using size_type  = std::size_t;
+
+        // Elements at the positions first + k * step, in increasing order, whose k modulo period is a set bit of
+        // mask: every k for progressions (period 1). Bit 0 is always set, and intervals of one element have step 1.
+        struct interval
+        {
+            _Ty first;
+            unsigned long long step;
+            unsigned long long count;
+            unsigned long long period = 1; // Length of the pattern in steps, at most 64.
+            std::uint64_t mask = 1;        // Steps of each period that hold an element.
+
+            // Number of elements in each period.
+            constexpr unsigned long long per_period() const noexcept
+            {
+                return detail::bit_count(mask);
+            }
+
+            // Number of steps from first to the element at index.
+            constexpr unsigned long long position(unsigned long long index) const noexcept
+            {
+                if (period == 1)
+                    return index;
+                const unsigned long long per = per_period();
+                return index / per * period + detail::nth_set_bit(mask, index % per);
+            }
+
+            // Number of elements at most steps from first.
+            constexpr unsigned long long count_through(unsigned long long steps) const noexcept
+            {
+                if (period == 1)
+                    return std::min(count, steps + 1);
+                return std::min(count, steps / period * per_period() + detail::bit_count(mask & detail::low_bits(steps % period + 1)));
+            }
+
+            constexpr _Ty value(unsigned long long index) const noexcept
+            {
+                return static_cast<_Ty>(static_cast<unsigned long long>(first) + position(index) * step);
+            }
+
+            constexpr _Ty last() const noexcept
+            {
+                return value(count - 1);
+            }
+
+            constexpr bool contains(_Ty v) const noexcept
+            {
+                const unsigned long long offset = static_cast<unsigned long long>(v) - static_cast<unsigned long long>(first);
+                return v >= first && v <= last() && offset % step == 0 && (period == 1 || ((mask >> (offset / step % period)) & 1) != 0);
+            }
+
+            // The elements from index on; index may be count, for the position that would continue the interval.
+            constexpr interval from(unsigned long long index) const noexcept
+            {
+                const unsigned long long phase = (period == 1) ? 0 : position(index) % period;
+                return interval{ value(index), step, count - index, period, detail::rotate_bits(mask, phase, period) };
+            }
+        };
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = _Ty;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = _Ty;
+
+            iterator() = default;
+
+            iterator(const interval* current, const interval* last) noexcept : m_interval(current), m_last(last)
+            {
+                if (current != last)
+                    m_value = current->first;
+            }
+
+            _Ty operator*() const noexcept
+            {
+                return m_value;
+            }
+
+            // Steps to the next set bit of the pattern, so periodic intervals need no division.
+            iterator& operator++() noexcept
+            {
+                const interval& current = *m_interval;
+                if (++m_index == current.count)
+                {
+                    if (++m_interval != m_last)
+                        m_value = m_interval->first;
+                    m_index = 0;
+                    m_phase = 0;
+                    return *this;
+                }
+                unsigned long long steps = 1;
+                if (current.period != 1)
+                {
+                    const std::uint64_t later = (m_phase + 1 < current.period) ? current.mask >> (m_phase + 1) : 0;
+                    steps = (later != 0) ? detail::trailing_zeros(later) + 1 : current.period - m_phase;
+                    m_phase = (later != 0) ? m_phase + steps : 0;
+                }
+                m_value = static_cast<_Ty>(static_cast<unsigned long long>(m_value) + steps * current.step);
+                return *this;
+            }
+
+            iterator operator++(int) noexcept
+            {
+                iterator temp = *this;
+                ++(*this);
+                return temp;
+            }
+
+            bool operator==(const iterator& right) const noexcept
+            {
+                return m_interval == right.m_interval && m_index == right.m_index;
+            }
+
+            bool operator!=(const iterator& right) const noexcept
+            {
+                return !(*this == right);
+            }
+
+        private:
+            const interval* m_interval = nullptr;
+            const interval* m_last = nullptr;
+            unsigned long long m_index = 0; // Position in *m_interval.
+            unsigned long long m_phase = 0; // Step of the current element within its period.
+            _Ty m_value{};                  // Element at m_index.
+        };
+
+        range_set() = default;
+
+        range_set(const range<_Ty>& values)
+        {
+            insert(values);
+        }
+
+        range_set(std::initializer_list<range<_Ty>> values)
+        {
+            for (const range<_Ty>& item : values)
+                insert(item);
+        }
+
+        // Adds the elements of values. Only the intervals overlapping them (and their neighbours) are rebuilt.
+        void insert(const range<_Ty>& values)
+        {
+            if (const std::optional<interval> piece = to_interval(values))
+                update(*piece, set_operation::unite);
+        }
+
+        void insert(_Ty value)
+        {
+            update(interval{ value, 1, 1 }, set_operation::unite);
+        }
+
+        // Removes the elements of values. Only the intervals overlapping them are rebuilt.
+        void erase(const range<_Ty>& values)
+        {
+            if (const std::optional<interval> piece = to_interval(values))
+                update(*piece, set_operation::subtract);
+        }
+
+        void erase(_Ty value)
+        {
+            update(interval{ value, 1, 1 }, set_operation::subtract);
+        }
+
+        void clear() noexcept
+        {
+            m_intervals.clear();
+            m_size = 0;
+        }
+
+        // Set algebra in one pass over the intervals of both sets.
+        _NPS_NODISCARD range_set unite(const range_set& other) const
+        {
+            return combined(other, set_operation::unite);
+        }
+
+        _NPS_NODISCARD range_set intersection(const range_set& other) const
+        {
+            return combined(other, set_operation::intersect);
+        }
+
+        _NPS_NODISCARD range_set difference(const range_set& other) const
+        {
+            return combined(other, set_operation::subtract);
+        }
+
+        friend range_set operator|(const range_set& left, const range_set& right)
+        {
+            return left.unite(right);
+        }
+
+        friend range_set operator&(const range_set& left, const range_set& right)
+        {
+            return left.intersection(right);
+        }
+
+        friend range_set operator-(const range_set& left, const range_set& right)
+        {
+            return left.difference(right);
+        }
+
+        range_set& operator|=(const range_set& other)
+        {
+            return *this = unite(other);
+        }
+
+        range_set& operator&=(const range_set& other)
+        {
+            return *this = intersection(other);
+        }
+
+        range_set& operator-=(const range_set& other)
+        {
+            return *this = difference(other);
+        }
+
+        _NPS_NODISCARD bool contains(_Ty value) const noexcept
+        {
+            // The last interval starting at or before value is the only one that can contain it.
+            const auto after = std::upper_bound(m_intervals.begin(), m_intervals.end(), value,
+                [](_Ty v, const interval& item) { return v < item.first; });
+            return after != m_intervals.begin() && std::prev(after)->contains(value);
+        }
+
+        _NPS_NODISCARD size_type size() const noexcept
+        {
+            return m_size;
+        }
+
+        _NPS_NODISCARD bool empty() const noexcept
+        {
+            return m_intervals.empty();
+        }
+
+        _NPS_NODISCARD size_type interval_count() const noexcept
+        {
+            return m_intervals.size();
+        }
+
+        _NPS_NODISCARD const std::vector<interval>& intervals() const noexcept
+        {
+            return m_intervals;
+        }
+
+        _NPS_NODISCARD _Ty front() const noexcept
+        {
+            _NPS_ASSERT(!empty(), "range_set cannot be empty");
+            return m_intervals.front().first;
+        }
+
+        _NPS_NODISCARD _Ty back() const noexcept
+        {
+            _NPS_ASSERT(!empty(), "range_set cannot be empty");
+            return m_intervals.back().last();
+        }
+
+        std::vector<_Ty> to_vector() const
+        {
+            std::vector<_Ty> result;
+            result.reserve(m_size);
+            for (const _Ty value : *this)
+                result.push_back(value);
+            return result;
+        }
+
+        _NPS_NODISCARD iterator begin() const noexcept
+        {
+            return iterator(m_intervals.data(), m_intervals.data() + m_intervals.size());
+        }
+
+        _NPS_NODISCARD iterator end() const noexcept
+        {
+            return iterator(m_intervals.data() + m_intervals.size(), m_intervals.data() + m_intervals.size());
+        }
+
+    private:
+        enum class set_operation { unite, intersect, subtract };
+
+        // Position in a sorted sequence of intervals.
+        struct cursor
+        {
+            const interval* current;
+            const interval* last;
+            unsigned long long index;
+            bool runs; // Whether periodic intervals are taken one run of consecutive steps at a time.
+
+            bool done() const noexcept
+            {
+                return current == last;
+            }
+
+            // The elements of the current interval from the position on, or of its current run.
+            interval rest() const noexcept
+            {
+                interval part = current->from(index);
+                if (runs && part.period != 1)
+                    part = interval{ part.first, part.step, std::min(part.count, detail::trailing_zeros(~part.mask)) };
+                return part;
+            }
+
+            void advance(unsigned long long count) noexcept
+            {
+                index += count;
+                if (index == current->count)
+                {
+                    ++current;
+                    index = 0;
+                }
+            }
+        };
+
+        static cursor cursor_of(const interval* first, const interval* last, bool runs = false) noexcept
+        {
+            return cursor{ first, last, 0, runs };
+        }
+
+        static std::optional<interval> to_interval(const range<_Ty>& values) noexcept
+        {
+            if (values.empty())
+                return std::nullopt;
+            const auto count = static_cast<unsigned long long>(values.end() - values.begin());
+            if (count == 1)
+                return interval{ values.front(), 1, 1 };
+            const auto first = static_cast<unsigned long long>(values.begin()[0]);
+            const auto second = static_cast<unsigned long long>(values.begin()[1]);
+            const unsigned long long step = (values.begin()[0] < values.begin()[1]) ? second - first : first - second;
+            return interval{ values.min(), step, count };
+        }
+
+        range_set combined(const range_set& other, set_operation operation) const
+        {
+            range_set result;
+            combine(cursor_of(m_intervals.data(), m_intervals.data() + m_intervals.size()),
+                cursor_of(other.m_intervals.data(), other.m_intervals.data() + other.m_intervals.size()), operation, result);
+            return result;
+        }
+
+        static unsigned long long distance(_Ty from, _Ty to) noexcept
+        {
+            return static_cast<unsigned long long>(to) - static_cast<unsigned long long>(from);
+        }
+
+        // Number of elements of part below bound.
+        static unsigned long long count_below(const interval& part, _Ty bound) noexcept
+        {
+            return (bound <= part.first) ? 0 : part.count_through((distance(part.first, bound) - 1) / part.step);
+        }
+
+        // Number of elements of part up to bound.
+        static unsigned long long count_through(const interval& part, _Ty bound) noexcept
+        {
+            return (bound < part.first) ? 0 : part.count_through(distance(part.first, bound) / part.step);
+        }
+
+        static void drop_front(interval& part, unsigned long long count) noexcept
+        {
+            part = part.from(count);
+        }
+
+        // Elements common to a and b in O(log step): those of a at the indices solving
+        // a.first + i * a.step = b.first (mod b.step), every lcm / a.step indices, within the hull of b.
+        static interval common(const interval& a, const interval& b) noexcept
+        {
+            const interval none{ a.first, 1, 0 };
+            const unsigned long long low = count_below(a, b.first);
+            const unsigned long long high = count_through(a, b.last());
+            if (low >= high)
+                return none;
+            const detail::congruence_solution solution = detail::solve_index_congruence(a.first, a.step, b.step, detail::floor_mod(b.first, b.step));
+            if (!solution.exists)
+                return none;
+            const unsigned long long first = low + detail::sub_mod(solution.first, low % solution.period, solution.period);
+            if (first >= high)
+                return none;
+            const unsigned long long count = (high - 1 - first) / solution.period + 1;
+            return interval{ a.value(first), (count == 1) ? 1 : a.step * solution.period, count };
+        }
+
+        // Merges the elements of a and b in increasing order, appending those selected by operation to out. Each
+        // pass takes the parts of the current intervals of both sides up to the end of the first one to finish,
+        // so the number of passes is linear in the number of intervals.
+        static void combine(cursor a, cursor b, set_operation operation, range_set& out)
+        {
+            const bool keep_a = (operation != set_operation::intersect);
+            const bool keep_b = (operation == set_operation::unite);
+            while (!a.done() && !b.done())
+            {
+                const interval a_rest = a.rest();
+                const interval b_rest = b.rest();
+                const _Ty through = std::min(a_rest.last(), b_rest.last());
+                interval a_part = a_rest;
+                interval b_part = b_rest;
+                a_part.count = count_through(a_rest, through);
+                b_part.count = count_through(b_rest, through);
+                if (a_part.count == 0)
+                {
+                    if (keep_b)
+                        out.append(b_part);
+                }
+                else if (b_part.count == 0)
+                {
+                    if (keep_a)
+                        out.append(a_part);
+                }
+                else
+                {
+                    combine_parts(a_part, b_part, operation, out);
+                }
+                a.advance(a_part.count);
+                b.advance(b_part.count);
+            }
+            for (; keep_a && !a.done(); a.advance(a.rest().count))
+                out.append(a.rest());
+            for (; keep_b && !b.done(); b.advance(b.rest().count))
+                out.append(b.rest());
+        }
+
+        // Combines two non-empty intervals whose elements all lie below the end of the other's interval. For
+        // progressions, intersections are closed forms of their common elements, and so are unions when one side
+        // contains the other or they interleave. Other results are periodic: they are evaluated over one period
+        // when it has at most 64 steps, and are otherwise built run by run.
+        static void combine_parts(const interval& a, const interval& b, set_operation operation, range_set& out)
+        {
+            if (a.period != 1 || b.period != 1)
+            {
+                if (a.count == 1 || b.count == 1)
+                    combine_element(a, b, operation, out);
+                else if (!combine_periodic(a, b, operation, out))
+                    combine(cursor_of(&a, &a + 1, true), cursor_of(&b, &b + 1, true), operation, out);
+                return;
+            }
+            const interval both = common(a, b);
+            if (operation == set_operation::intersect)
+            {
+                if (both.count != 0)
+                    out.append(both);
+            }
+            else if (operation == set_operation::subtract)
+            {
+                if (!combine_periodic(a, b, operation, out))
+                    remove_common(a, both, out);
+            }
+            else if (both.count == b.count)
+            {
+                out.append(a);
+            }
+            else if (both.count == a.count)
+            {
+                out.append(b);
+            }
+            else if (!interleave(a, b, out) && !interleave(b, a, out) && !combine_periodic(a, b, operation, out))
+            {
+                merge(a, b, out);
+            }
+        }
+
+        // Combines a and b when one of them is a single element, by splitting the other around it.
+        static void combine_element(const interval& a, const interval& b, set_operation operation, range_set& out)
+        {
+            const bool single_a = (a.count == 1);
+            const interval& whole = single_a ? b : a;
+            const _Ty element = single_a ? a.first : b.first;
+            const bool found = whole.contains(element);
+            if (operation == set_operation::intersect)
+            {
+                if (found)
+                    out.append(interval{ element, 1, 1 });
+            }
+            else if (operation == set_operation::subtract && single_a)
+            {
+                if (!found)
+                    out.append(interval{ element, 1, 1 });
+            }
+            else
+            {
+                const unsigned long long below = count_below(whole, element);
+                if (below != 0)
+                    out.append(interval{ whole.first, whole.step, below, whole.period, whole.mask });
+                if (operation == set_operation::unite)
+                    out.append(interval{ element, 1, 1 });
+                const unsigned long long skip = below + (found ? 1 : 0);
+                if (skip < whole.count)
+                    out.append(whole.from(skip));
+            }
+        }
+
+        // Combines a and b in closed form if the result is periodic with at most 64 steps, e.g. the even numbers
+        // without the multiples of 6, which hold steps 0 and 1 of every 3 steps of 2 from 2 on. The elements of
+        // either side before the start or after the end of the other are appended whole, and where both overlap,
+        // the steps of one period of the result are evaluated once and appended as a single interval.
+        static bool combine_periodic(const interval& a, const interval& b, set_operation operation, range_set& out)
+        {
+            constexpr unsigned long long max_period = 64;
+            const bool keep_a = (operation != set_operation::intersect);
+            const bool keep_b = (operation == set_operation::unite);
+            const interval& low = (b.first < a.first) ? b : a;
+            const interval& high = (b.first < a.first) ? a : b;
+            const bool keep_low = (&low == &a) ? keep_a : keep_b;
+            const _Ty through = std::min(a.last(), b.last());
+            if (through < high.first)
+            {
+                if (keep_low)
+                    out.append(low);
+                if ((&high == &a) ? keep_a : keep_b)
+                    out.append(high);
+                return true;
+            }
+
+            // Both sides lie on the lattice of the greatest common step through the start of the overlap.
+            const unsigned long long step = std::gcd(std::gcd(a.step, b.step), distance(low.first, high.first));
+            const unsigned long long a_steps = a.step / step;
+            const unsigned long long b_steps = b.step / step;
+            if (a_steps > max_period || b_steps > max_period)
+                return false;
+            const unsigned long long period = std::lcm(a_steps * a.period, b_steps * b.period);
+            if (period > max_period)
+                return false;
+
+            const unsigned long long head = count_below(low, high.first);
+            if (keep_low && head != 0)
+                out.append(interval{ low.first, low.step, head, low.period, low.mask });
+
+            // Whether the element k steps after the start of the overlap belongs to side.
+            const auto holds = [&](const interval& side, unsigned long long side_steps, unsigned long long k) noexcept
+            {
+                const unsigned long long side_period = side_steps * side.period;
+                const unsigned long long offset = (distance(side.first, high.first) / step % side_period + k) % side_period;
+                return offset % side_steps == 0 && ((side.mask >> (offset / side_steps)) & 1) != 0;
+            };
+            std::uint64_t pattern = 0;
+            for (unsigned long long k = 0; k < period; ++k)
+            {
+                const bool in_a = holds(a, a_steps, k);
+                const bool in_b = holds(b, b_steps, k);
+                const bool in = (operation == set_operation::unite) ? (in_a || in_b)
+                    : (operation == set_operation::intersect) ? (in_a && in_b) : (in_a && !in_b);
+                pattern |= std::uint64_t{ in } << k;
+            }
+            const unsigned long long steps = distance(high.first, through) / step;
+            if (pattern != 0 && detail::trailing_zeros(pattern) <= steps)
+            {
+                const unsigned long long skip = detail::trailing_zeros(pattern);
+                interval overlap{ static_cast<_Ty>(static_cast<unsigned long long>(high.first) + skip * step), step,
+                    std::numeric_limits<unsigned long long>::max(), period, detail::rotate_bits(pattern, skip, period) };
+                overlap.count = overlap.count_through(steps - skip);
+                out.append(overlap);
+            }
+
+            const interval& longer = (a.last() < b.last()) ? b : a;
+            const unsigned long long tail = count_through(longer, through);
+            if (((&longer == &a) ? keep_a : keep_b) && tail < longer.count)
+                out.append(longer.from(tail));
+            return true;
+        }
+
+        // Appends the elements of a that are not in both, a subset of a: the runs of a between the common elements.
+        // Removing every other element of a leaves one progression of twice the step.
+        static void remove_common(const interval& a, const interval& both, range_set& out)
+        {
+            if (both.count == 0)
+            {
+                out.append(a);
+                return;
+            }
+            const unsigned long long first = distance(a.first, both.first) / a.step;
+            const unsigned long long period = (both.count == 1) ? 1 : both.step / a.step;
+            if (first != 0)
+                out.append(interval{ a.first, a.step, first });
+            if (period == 2)
+            {
+                out.append(interval{ a.value(first + 1), both.step, both.count - 1 });
+            }
+            else if (period > 2)
+            {
+                for (unsigned long long i = 0; i + 1 < both.count; ++i)
+                    out.append(interval{ a.value(first + i * period + 1), a.step, period - 1 });
+            }
+            const unsigned long long last = first + (both.count - 1) * period;
+            if (last + 1 < a.count)
+                out.append(interval{ a.value(last + 1), a.step, a.count - last - 1 });
+        }
+
+        // Unites low and high when they have the same step and high starts half a step after low, e.g. the even and
+        // the odd numbers: together they form one progression of half the step.
+        static bool interleave(const interval& low, const interval& high, range_set& out)
+        {
+            const unsigned long long step = low.step;
+            if (step != high.step || step % 2 != 0 || !(low.first < high.first) || distance(low.first, high.first) != step / 2
+                || (low.count != high.count && low.count != high.count + 1))
+                return false;
+            out.append(interval{ low.first, step / 2, low.count + high.count });
+            return true;
+        }
+
+        // Unites a and b run by run: the elements of one side below the next element of the other are appended whole.
+        static void merge(interval a, interval b, range_set& out)
+        {
+            while (a.count != 0 && b.count != 0)
+            {
+                if (a.first < b.first)
+                {
+                    const unsigned long long count = count_below(a, b.first);
+                    out.append(interval{ a.first, a.step, count });
+                    drop_front(a, count);
+                }
+                else if (b.first < a.first)
+                {
+                    const unsigned long long count = count_below(b, a.first);
+                    out.append(interval{ b.first, b.step, count });
+                    drop_front(b, count);
+                }
+                else
+                {
+                    out.append(interval{ a.first, 1, 1 });
+                    drop_front(a, 1);
+                    drop_front(b, 1);
+                }
+            }
+            if (a.count != 0)
+                out.append(a);
+            if (b.count != 0)
+                out.append(b);
+        }
+
+        // part with the shortest period and the longest step of its pattern. Parts of one or two elements, and
+        // patterns of one element per period, become progressions.
+        static interval reduced(interval part) noexcept
+        {
+            if (part.count <= 2)
+                return (part.count == 1) ? interval{ part.first, 1, 1 } : interval{ part.first, part.position(1) * part.step, 2 };
+            for (unsigned long long length = 1; length < part.period; ++length)
+            {
+                if (part.period % length == 0 && (((part.mask >> length) ^ part.mask) & detail::low_bits(part.period - length)) == 0)
+                {
+                    part.period = length;
+                    part.mask &= detail::low_bits(length);
+                    break;
+                }
+            }
+            unsigned long long spacing = part.period;
+            for (std::uint64_t bits = part.mask; bits != 0; bits &= bits - 1)
+                spacing = std::gcd(spacing, detail::trailing_zeros(bits));
+            if (spacing != 1)
+            {
+                std::uint64_t mask = 0;
+                for (std::uint64_t bits = part.mask; bits != 0; bits &= bits - 1)
+                    mask |= std::uint64_t{ 1 } << (detail::trailing_zeros(bits) / spacing);
+                part = interval{ part.first, part.step * spacing, part.count, part.period / spacing, mask };
+            }
+            return part;
+        }
+
+        // Appends the elements of part, which are above every element of the set, extending the last interval
+        // when they continue its pattern.
+        void append(const interval& part)
+        {
+            const interval next = reduced(part);
+            m_size += static_cast<size_type>(next.count);
+            if (!m_intervals.empty())
+            {
+                interval& back = m_intervals.back();
+                if (back.period == 1 && next.period == 1)
+                {
+                    const unsigned long long gap = static_cast<unsigned long long>(next.first) - static_cast<unsigned long long>(back.last());
+                    if (back.count == 1 && (next.count == 1 || gap == next.step))
+                    {
+                        back.step = gap;
+                        back.count += next.count;
+                        return;
+                    }
+                    if (gap == back.step && (next.count == 1 || next.step == back.step))
+                    {
+                        back.count += next.count;
+                        return;
+                    }
+                }
+                else if (back.period != 1)
+                {
+                    const interval expected = back.from(back.count);
+                    if (next.first == expected.first && (next.count == 1
+                        || (next.count == 2 && next.value(1) == expected.value(1))
+                        || (next.step == expected.step && next.period == expected.period && next.mask == expected.mask)))
+                    {
+                        back.count += next.count;
+                        return;
+                    }
+                }
+            }
+            m_intervals.push_back(next);
+        }
+
+        // Applies operation between the set and piece, rebuilding only the intervals whose hulls overlap the
+        // piece. A union also takes the intervals on either side, so that the piece is coalesced with them.
+        void update(const interval& piece, set_operation operation)
+        {
+            auto first = std::lower_bound(m_intervals.begin(), m_intervals.end(), piece.first,
+                [](const interval& item, _Ty v) { return item.last() < v; });
+            auto last = std::upper_bound(first, m_intervals.end(), piece.last(),
+                [](_Ty v, const interval& item) { return v < item.first; });
+            if (operation == set_operation::unite)
+            {
+                if (first != m_intervals.begin())
+                    --first;
+                if (last != m_intervals.end())
+                    ++last;
+            }
+            range_set window;
+            const interval* data = m_intervals.data();
+            combine(cursor_of(data + (first - m_intervals.begin()), data + (last - m_intervals.begin())),
+                cursor_of(&piece, &piece + 1), operation, window);
+            for (auto it = first; it != last; ++it)
+                m_size -= static_cast<size_type>(it->count);
+            m_size += window.m_size;
+            const auto position = m_intervals.erase(first, last);
+            m_intervals.insert(position, window.m_intervals.begin(), window.m_intervals.end());
+        }
+
+        std::vector<interval> m_intervals; // Sorted by first; the hulls [first, last()] do not overlap.
+        size_type m_size = 0;              // Total number of elements.
+    };
+
+    // Type aliases for common numeric ranges.
+    // These types allow convenient access to common range types for various data types.
+
+    using crange = range<char>;
+    using ucrange = range<unsigned char>;
+    using srange = range<short>;
+    using usrange = range<unsigned short>;
+    using irange = range<int>;
+    using uirange = range<unsigned int>;
+    using lrange = range<long>;
+    using ulrange = range<unsigned long>;
+    using llrange = range<long long>;
+    using ullrange = range<unsigned long long>;
+    using frange = range<float>;
+    using drange = range<double>;
+    using ldrange = range<long double>;
+
+    template <class _Ty = int, std::enable_if_t<std::is_arithmetic_v<_Ty>, int> = 0>
+    constexpr range<_Ty> empty_range = range{};
+
+    // Integral range whose bounds and step are template arguments. Its size and elements are constant
+    // expressions, and for_each() is expanded into one call per element with no runtime loop.
+    // The step is normalized towards _End exactly like range::reset.
+    template <class _Ty, _Ty _Start, _Ty _End, long long _Step = 1>
+    class static_range
+    {
+        static_assert(std::is_integral_v<_Ty>, "static_range requires an integral type");
+        static_assert(_Step != 0, "step cannot be equal to 0");
+    public:
+        using range_type    = _Ty;
+        using step_type     = long long;
+        using size_type     = step_type;
+        using iterator      = range_iterator<_Ty, step_type>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+
+        static constexpr _Ty start_value = _Start;
+        static constexpr _Ty end_value = _End;
+        static constexpr step_type step_value = (_Start == _End) ? 0 : ((_Start < _End) == (_Step > 0)) ? _Step : -_Step;
+
+        _NPS_NODISCARD static constexpr size_type size() noexcept
+        {
+            return static_cast<size_type>(detail::integral_count(_Start, _End, step_value));
+        }
+
+        _NPS_NODISCARD static constexpr bool empty() noexcept
+        {
+            return size() == 0;
+        }
+
+        // Element at the zero-based index.
+        _NPS_NODISCARD static constexpr _Ty at(size_type index) noexcept
+        {
+            return detail::progression_value(_Start, step_value, static_cast<std::ptrdiff_t>(index));
+        }
+
+        _NPS_NODISCARD static constexpr _Ty nth_step(size_type n) noexcept
+        {
+            return at(n - 1);
+        }
+
+        _NPS_NODISCARD static constexpr _Ty front() noexcept
+        {
+            static_assert(size() != 0, "range cannot be empty");
+            return at(0);
+        }
+
+        _NPS_NODISCARD static constexpr _Ty back() noexcept
+        {
+            static_assert(size() != 0, "range cannot be empty");
+            return at(size() - 1);
+        }
+
+        _NPS_NODISCARD static constexpr iterator begin() noexcept
+        {
+            return iterator(_Start, step_value);
+        }
+
+        _NPS_NODISCARD static constexpr iterator end() noexcept
+        {
+            return iterator(_Start, step_value, static_cast<typename iterator::difference_type>(size()));
+        }
+
+        _NPS_NODISCARD static constexpr reverse_iterator rbegin() noexcept
+        {
+            return reverse_iterator(end());
+        }
+
+        _NPS_NODISCARD static constexpr reverse_iterator rend() noexcept
+        {
+            return reverse_iterator(begin());
+        }
+
+        // Calls func(value) for every element, expanded at compile time.
+        template <class _Fn>
+        static constexpr void for_each(_Fn&& func)
+        {
+            for_each_impl(func, std::make_index_sequence<static_cast<std::size_t>(size())>{});
+        }
+
+        template <step_type _NewStep>
+        _NPS_NODISCARD static constexpr static_range<_Ty, _Start, _End, _NewStep> step() noexcept
+        {
+            return {};
+        }
+
+        // Elements with indices [_First, _Last), like range::slice.
+        template <size_type _First, size_type _Last>
+        _NPS_NODISCARD static constexpr auto slice() noexcept
+        {
+            static_assert(_First <= _Last && _Last <= size(), "slice indices are out of range");
+            // at(size()) is one step past the last element and can wrap for narrow types, so a slice reaching the
+            // end keeps _End, and an empty slice does not compute an element at all.
+            if constexpr (_First == _Last)
+                return static_range<_Ty, _Start, _Start, 1>{};
+            else if constexpr (_Last == size())
+                return static_range<_Ty, at(_First), _End, step_value>{};
+            else
+                return static_range<_Ty, at(_First), at(_Last), step_value>{};
+        }
+
+        // The same elements in the opposite order.
+        _NPS_NODISCARD static constexpr auto reverse() noexcept
+        {
+            if constexpr (size() == 0)
+            {
+                return static_range<_Ty, _Start, _Start, 1>{};
+            }
+            else
+            {
+                constexpr _Ty new_end = detail::progression_value(_Start, step_value, -1);
+                static_assert((step_value > 0) ? (new_end < _Start) : (new_end > _Start), "the reversed range cannot be represented in _Ty");
+                return static_range<_Ty, back(), new_end, -step_value>{};
+            }
+        }
+
+        // All elements as a std::array in a constant expression.
+        _NPS_NODISCARD static constexpr std::array<_Ty, static_cast<std::size_t>(size())> to_array() noexcept
+        {
+            return to_array([](_Ty value) { return value; });
+        }
+
+        // All elements transformed by func as a std::array.
+        template <class _Fn>
+        _NPS_NODISCARD static constexpr auto to_array(_Fn&& func)
+        {
+            return detail::make_array<static_cast<std::size_t>(size())>([&func](std::size_t index)
+            {
+                return func(at(static_cast<size_type>(index)));
+            });
+        }
+
+        _NPS_NODISCARD static constexpr range<_Ty> to_range() noexcept
+        {
+            return range<_Ty>(_Start, _End, step_value == 0 ? 1 : step_value);
+        }
+
+        constexpr operator range<_Ty>() const noexcept
+        {
+            return to_range();
+        }
+
+    private:
+        template <class _Fn, std::size_t... _Indices>
+        static constexpr void for_each_impl(_Fn& func, std::index_sequence<_Indices...>)
+        {
+            (static_cast<void>(func(at(static_cast<size_type>(_Indices)))), ...);
+        }
+    };
+
+    namespace detail
+    {
+        template <class _Range, class _Fn, std::size_t... _Indices>
+        constexpr void static_for_impl(_Fn& body, std::index_sequence<_Indices...>)
+        {
+            using value_type = typename _Range::range_type;
+            (static_cast<void>(body(std::integral_constant<value_type, _Range::at(static_cast<typename _Range::size_type>(_Indices))>{})), ...);
+        }
+    }
+
+    // Calls body(std::integral_constant<_Ty, value>{}) for every element of a static_range, so the body can
+    // use the value as a template argument. The calls are expanded at compile time with no runtime loop.
+    //   nps::static_for<nps::static_range<int, 0, 4>>([&](auto i) { std::get<i>(tuple) = i; });
+    template <class _Range, class _Fn>
+    constexpr void static_for(_Fn&& body)
+    {
+        detail::static_for_impl<_Range>(body, std::make_index_sequence<static_cast<std::size_t>(_Range::size())>{});
+    }
+
+    // Same as above for a static_range value, e.g. static_for(lanes::reverse(), body).
+    template <class _Ty, _Ty _Start, _Ty _End, long long _Step, class _Fn>
+    constexpr void static_for(static_range<_Ty, _Start, _End, _Step>, _Fn&& body)
+    {
+        static_for<static_range<_Ty, _Start, _End, _Step>>(body);
+    }
+
+    // Same as above for static_range<decltype(_Start), _Start, _End, _Step>, e.g. static_for<0, 8>(body).
+    template <auto _Start, decltype(_Start) _End, long long _Step = 1, class _Fn>
+    constexpr void static_for(_Fn&& body)
+    {
+        static_for<static_range<decltype(_Start), _Start, _End, _Step>>(body);
+    }
+
+    namespace detail
+    {
+        // Piece [lo, hi) of the index space of a parallel job. Pieces are what idle threads steal;
+        // a range is split in O(1) by splitting its index interval.
+        struct work_item
+        {
+            struct work_job* job;
+            std::size_t lo;
+            std::size_t hi;
+        };
+
+        struct work_job
+        {
+            work_job(void (*_Invoke)(void*, std::size_t, std::size_t), void* _Body, std::size_t _Grain, std::size_t _Count) noexcept
+                : invoke(_Invoke), body(_Body), grain(_Grain), pending(_Count) {}
+
+            void (*const invoke)(void*, std::size_t, std::size_t);
+            void* const body;
+            const std::size_t grain;
+            std::atomic<std::size_t> pending;       // Indices not yet executed.
+            std::atomic<bool> failed{ false };
+            std::exception_ptr error;
+        };
+
+        // Chase-Lev deque of bounded capacity. The owning thread pushes and pops at the bottom,
+        // any other thread steals from the top.
+        class work_deque
+        {
+        public:
+            static constexpr std::ptrdiff_t capacity = 1024;
+
+            // Owner only. Fails when the deque is full; the caller then keeps the work itself.
+            bool push(work_item* item) noexcept
+            {
+                const std::ptrdiff_t bottom = m_bottom.load(std::memory_order_relaxed);
+                const std::ptrdiff_t top = m_top.load(std::memory_order_acquire);
+                if (bottom - top >= capacity)
+                    return false;
+                m_items[bottom & (capacity - 1)].store(item, std::memory_order_release);
+                std::atomic_thread_fence(std::memory_order_release);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return true;
+            }
+
+            // Owner only.
+            work_item* pop() noexcept
+            {
+                const std::ptrdiff_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+                m_bottom.store(bottom, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::ptrdiff_t top = m_top.load(std::memory_order_relaxed);
+                if (top > bottom)
+                {
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                work_item* item = m_items[bottom & (capacity - 1)].load(std::memory_order_relaxed);
+                if (top == bottom)
+                {
+                    // Last item: race the thieves for it.
+                    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                        item = nullptr;
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                }
+                return item;
+            }
+
+            work_item* steal() noexcept
+            {
+                std::ptrdiff_t top = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const std::ptrdiff_t bottom = m_bottom.load(std::memory_order_acquire);
+                if (top >= bottom)
+                    return nullptr;
+                work_item* item = m_items[top & (capacity - 1)].load(std::memory_order_acquire);
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    return nullptr;
+                return item;
+            }
+
+            // Owner only; a hint, thieves may empty the deque at any time.
+            bool empty() const noexcept
+            {
+                return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+            }
+
+        private:
+            alignas(64) std::atomic<std::ptrdiff_t> m_top{ 0 };
+            alignas(64) std::atomic<std::ptrdiff_t> m_bottom{ 0 };
+            std::atomic<work_item*> m_items[capacity];
+        };
+    }
+
+    // Work-stealing pool of persistent worker threads used by the parallel range algorithms.
+    // Every thread owns a deque of pending pieces. A thread executing a piece splits off the upper half
+    // whenever its own deque is empty (lazy binary splitting), and idle threads steal the oldest pieces.
+    // Threads waiting for a job keep executing pending pieces, so nested parallel loops run on the same
+    // threads without oversubscription or deadlock.
+    class thread_pool
+    {
+    public:
+        explicit thread_pool(std::size_t thread_count = std::max(1u, std::thread::hardware_concurrency()))
+            : m_slots(std::max<std::size_t>(thread_count, 1)), m_deques(new detail::work_deque[m_slots])
+        {
+            // Slot 0 belongs to the external thread currently calling run().
+            m_workers.reserve(m_slots - 1);
+            for (std::size_t slot = 1; slot < m_slots; ++slot)
+                m_workers.emplace_back([this, slot] { worker_loop(slot); });
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        ~thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop.store(true, std::memory_order_release);
+                ++m_epoch;
+            }
+            m_wake.notify_all();
+            for (std::thread& worker : m_workers)
+                worker.join();
+        }
+
+        // Number of threads taking part in run(), including the calling thread.
+        _NPS_NODISCARD std::size_t size() const noexcept
+        {
+            return m_slots;
+        }
+
+        // Calls body(lo, hi) for disjoint chunks of at most grain_size indices covering [0, count)
+        // and returns once all of them have finished. The first exception thrown by body is rethrown
+        // here; the chunks not started yet are skipped.
+        template <class _Fn>
+        void run(std::size_t count, std::size_t grain_size, _Fn&& body)
+        {
+            if (count == 0)
+                return;
+            detail::work_job job(&invoke<std::remove_reference_t<_Fn>>, std::addressof(body), std::max<std::size_t>(grain_size, 1), count);
+            const auto finished = [&job] { return job.pending.load(std::memory_order_acquire) == 0; };
+
+            const worker_context self = current_worker();
+            if (self.pool == this)
+            {
+                const run_scope scope(*this, self.slot, job, false);
+                execute_range(self.slot, job, 0, count);
+                work_until(self.slot, finished);
+            }
+            else if (m_external.try_lock())
+            {
+                const run_scope scope(*this, 0, job, true);
+                execute_range(0, job, 0, count);
+                work_until(0, finished);
+            }
+            else
+            {
+                // Another external thread holds slot 0. Publish the job to the workers and help
+                // by stealing; without a deque this thread executes pieces without splitting them.
+                const run_scope scope(*this, no_slot, job, false);
+                if (publish(new (std::nothrow) detail::work_item{ &job, 0, count }))
+                    notify_waiters(false);
+                else
+                    execute_range(no_slot, job, 0, count);
+                work_until(no_slot, finished);
+            }
+            if (job.error)
+                std::rethrow_exception(job.error);
+        }
+
+    private:
+        static constexpr std::size_t no_slot = static_cast<std::size_t>(-1);
+
+        struct worker_context
+        {
+            thread_pool* pool;
+            std::size_t slot;
+        };
+
+        static worker_context& current_worker() noexcept
+        {
+            static thread_local worker_context context{ nullptr, 0 };
+            return context;
+        }
+
+        // Keeps run() from returning, even by an exception, while pieces of its job are pending: they point to the
+        // job on run()'s stack. The external thread then runs what is left in the deque of slot 0, restores its
+        // context and releases the slot.
+        class run_scope
+        {
+        public:
+            run_scope(thread_pool& pool, std::size_t slot, const detail::work_job& job, bool external) noexcept
+                : m_pool(pool), m_slot(slot), m_job(job), m_external(external), m_saved(current_worker())
+            {
+                if (m_external)
+                    current_worker() = { &pool, 0 };
+            }
+
+            run_scope(const run_scope&) = delete;
+            run_scope& operator=(const run_scope&) = delete;
+
+            ~run_scope()
+            {
+                while (m_job.pending.load(std::memory_order_acquire) != 0)
+                {
+                    if (detail::work_item* item = (m_slot == no_slot) ? nullptr : m_pool.m_deques[m_slot].pop())
+                        m_pool.execute(m_slot, item);
+                    else
+                        std::this_thread::yield();
+                }
+                if (m_external)
+                {
+                    while (detail::work_item* item = m_pool.m_deques[0].pop())
+                        m_pool.execute(0, item);
+                    current_worker() = m_saved;
+                    m_pool.m_external.unlock();
+                }
+            }
+
+        private:
+            thread_pool& m_pool;
+            const std::size_t m_slot;
+            const detail::work_job& m_job;
+            const bool m_external;
+            const worker_context m_saved;
+        };
+
+        template <class _Fn>
+        static void invoke(void* body, std::size_t lo, std::size_t hi)
+        {
+            (*static_cast<_Fn*>(body))(lo, hi);
+        }
+
+        // Executes pending pieces from the given slot until finished() holds, sleeping while there is nothing to do.
+        template <class _Pred>
+        void work_until(std::size_t slot, const _Pred& finished)
+        {
+            unsigned idle_rounds = 0;
+            while (!finished())
+            {
+                if (detail::work_item* item = find_work(slot))
+                {
+                    execute(slot, item);
+                    idle_rounds = 0;
+                    continue;
+                }
+                if (++idle_rounds < 64)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                idle_rounds = 0;
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                const unsigned long long epoch = m_epoch;
+                m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+                lock.unlock();
+                // Look once more after announcing the sleep, so work published meanwhile is not missed.
+                if (detail::work_item* item = find_work(slot))
+                {
+                    m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+                    execute(slot, item);
+                    continue;
+                }
+                lock.lock();
+                m_wake.wait(lock, [&] { return m_epoch != epoch || finished(); });
+                m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        void execute(std::size_t slot, detail::work_item* item)
+        {
+            const detail::work_item piece = *item;
+            delete item;
+            execute_range(slot, *piece.job, piece.lo, piece.hi);
+        }
+
+        void execute_range(std::size_t slot, detail::work_job& job, std::size_t lo, std::size_t hi)
+        {
+            while (lo < hi)
+            {
+                if (slot != no_slot && hi - lo > job.grain && m_deques[slot].empty())
+                {
+                    const std::size_t mid = lo + (hi - lo) / 2;
+                    // Without memory for the piece, or room in the deque, the chunk runs here unsplit.
+                    detail::work_item* upper = new (std::nothrow) detail::work_item{ &job, mid, hi };
+                    if (upper != nullptr && m_deques[slot].push(upper))
+                    {
+                        hi = mid;
+                        notify_waiters(false);
+                        continue;
+                    }
+                    delete upper;
+                }
+
+                const std::size_t chunk_end = lo + std::min(job.grain, hi - lo);
+                if (!job.failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        job.invoke(job.body, lo, chunk_end);
+                    }
+                    catch (...)
+                    {
+                        if (!job.failed.exchange(true))
+                            job.error = std::current_exception();
+                    }
+                }
+                const std::size_t done = chunk_end - lo;
+                lo = chunk_end;
+                // job may be destroyed by its owner as soon as pending reaches 0.
+                if (job.pending.fetch_sub(done, std::memory_order_acq_rel) == done)
+                    notify_waiters(true);
+            }
+        }
+
+        // Hands item to the workers through the shared list. Returns false, leaving the work to the caller,
+        // when item could not be allocated or listed.
+        bool publish(detail::work_item* item) noexcept
+        {
+            if (item == nullptr)
+                return false;
+            try
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_injected.push_back(item);
+                m_injected_count.fetch_add(1, std::memory_order_release);
+                return true;
+            }
+            catch (...)
+            {
+                delete item;
+                return false;
+            }
+        }
+
+        detail::work_item* find_work(std::size_t slot)
+        {
+            if (slot != no_slot)
+            {
+                if (detail::work_item* item = m_deques[slot].pop())
+                    return item;
+            }
+            if (m_injected_count.load(std::memory_order_acquire) != 0)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_injected.empty())
+                {
+                    detail::work_item* item = m_injected.back();
+                    m_injected.pop_back();
+                    m_injected_count.fetch_sub(1, std::memory_order_relaxed);
+                    return item;
+                }
+            }
+            const std::size_t first = (slot == no_slot) ? 0 : slot + 1;
+            for (std::size_t i = 0; i < m_slots; ++i)
+            {
+                const std::size_t victim = (first + i) % m_slots;
+                if (victim == slot)
+                    continue;
+                if (detail::work_item* item = m_deques[victim].steal())
+                    return item;
+            }
+            return nullptr;
+        }
+
+        // Wakes one sleeping thread after new work was published, or all of them after a job finished.
+        void notify_waiters(bool all)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_sleeping.load(std::memory_order_relaxed) == 0)
+                return;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_epoch;
+            }
+            if (all)
+                m_wake.notify_all();
+            else
+                m_wake.notify_one();
+        }
+
+        void worker_loop(std::size_t slot)
+        {
+            current_worker() = { this, slot };
+            work_until(slot, [this] { return m_stop.load(std::memory_order_acquire); });
+        }
+
+        std::size_t m_slots;                                // Workers plus the external slot 0.
+        std::unique_ptr<detail::work_deque[]> m_deques;     // One deque per slot.
+        std::vector<std::thread> m_workers;
+        std::mutex m_external;                              // Held by the external thread using slot 0.
+        std::mutex m_mutex;
+        std::condition_variable m_wake;                     // Wakes threads sleeping in work_until.
+        std::vector<detail::work_item*> m_injected;         // Jobs of external threads without a slot, guarded by m_mutex.
+        std::atomic<std::size_t> m_injected_count{ 0 };
+        std::atomic<std::size_t> m_sleeping{ 0 };
+        unsigned long long m_epoch = 0;                     // Bumped under m_mutex whenever sleepers should look again.
+        std::atomic<bool> m_stop{ false };
+    };
+
+    // Pool shared by the parallel algorithms when no pool is given. Started on first use.
+    inline thread_pool& default_thread_pool()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+    // Calls func(value) for every element of r on the threads of pool.
+    // Idle threads steal halves of the remaining index space; grain_size is the smallest piece that is split
+    // further, 0 picks a size that leaves every thread many pieces for uneven per-element costs.
+    template <class _Ty, class _Fn>
+    void parallel_for(const range<_Ty>& r, _Fn&& func, std::size_t grain_size = 0, thread_pool& pool = default_thread_pool())
+    {
+        const auto count = static_cast<std::size_t>(r.end() - r.begin());
+        if (count == 0)
+            return;
+        if (grain_size == 0)
+            grain_size = std::max<std::size_t>(1, count / (pool.size() * 16));
+
+        using difference_type = typename range<_Ty>::iterator::difference_type;
+        const auto first = r.begin();
+        pool.run(count, grain_size, [&](std::size_t lo, std::size_t hi)
+        {
+            const auto last = first + static_cast<difference_type>(hi);
+            for (auto it = first + static_cast<difference_type>(lo); it != last; ++it)
+                func(*it);
+        });
+    }
+
+    namespace detail
+    {
+        // Whether some element of r for which predicate returns _Match exists, searched on the threads of pool.
+        // The first witness raises a shared flag; every worker checks it before each chunk and every few
+        // elements inside one, so the remaining work is abandoned shortly after.
+        template <bool _Match, class _Ty, class _Fn>
+        bool parallel_find_witness(const range<_Ty>& r, _Fn& predicate, std::size_t grain_size, thread_pool& pool)
+        {
+            constexpr std::size_t check_interval = 1024;
+            const auto count = static_cast<std::size_t>(r.end() - r.begin());
+            if (count == 0)
+                return false;
+            if (grain_size == 0)
+                grain_size = std::max<std::size_t>(1, count / (pool.size() * 16));
+
+            using difference_type = typename range<_Ty>::iterator::difference_type;
+            const auto first = r.begin();
+            std::atomic<bool> found{ false };
+            pool.run(count, grain_size, [&](std::size_t lo, std::size_t hi)
+            {
+                while (lo < hi && !found.load(std::memory_order_relaxed))
+                {
+                    const std::size_t block_end = std::min(hi, lo + check_interval);
+                    for (; lo < block_end; ++lo)
+                    {
+                        if (static_cast<bool>(predicate(first[static_cast<difference_type>(lo)])) == _Match)
+                        {
+                            found.store(true, std::memory_order_relaxed);
+                            return;
+                        }
+                    }
+                }
+            });
+            return found.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Parallel counterparts of range::any_of, all_of and none_of. The result does not depend on scheduling;
+    // the search stops soon after any thread finds an element deciding it.
+    template <class _Ty, class _Fn>
+    bool parallel_any_of(const range<_Ty>& r, _Fn&& predicate, std::size_t grain_size = 0, thread_pool& pool = default_thread_pool())
+    {
+        return detail::parallel_find_witness<true>(r, predicate, grain_size, pool);
+    }
+
+    template <class _Ty, class _Fn>
+    bool parallel_all_of(const range<_Ty>& r, _Fn&& predicate, std::size_t grain_size = 0, thread_pool& pool = default_thread_pool())
+    {
+        return !detail::parallel_find_witness<false>(r, predicate, grain_size, pool);
+    }
+
+    template <class _Ty, class _Fn>
+    bool parallel_none_of(const range<_Ty>& r, _Fn&& predicate, std::size_t grain_size = 0, thread_pool& pool = default_thread_pool())
+    {
+        return !detail::parallel_find_witness<true>(r, predicate, grain_size, pool);
+    }
+
+    // Product of _Dims ranges whose elements are coordinate arrays. In the default loop order dimension 0
+    // varies slowest, like hand-written nested loops. The traversal can be tiled (blocked) for cache reuse,
+    // and the loop order can be given explicitly or derived from the memory strides of the data visited.
+    template <class _Ty, std::size_t _Dims>
+    class nd_range
+    {
+        static_assert(_Dims > 0, "nd_range needs at least one dimension");
+    public:
+        using range_type    = range<_Ty>;
+        using value_type    = std::array<_Ty, _Dims>;
+        using index_type    = std::array<std::ptrdiff_t, _Dims>;
+        using order_type    = std::array<std::size_t, _Dims>;
+        using size_type     = std::ptrdiff_t;
+
+        // Visits the elements tile by tile, in the loop order both across and inside the tiles.
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = typename nd_range::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = value_type;
+
+            iterator() = default;
+
+            iterator(const nd_range* owner, size_type position) noexcept
+                : m_owner(owner), m_index(), m_origin(), m_position(position) {}
+
+            value_type operator*() const
+            {
+                return m_owner->at(m_index);
+            }
+
+            // Multi-index of the current element.
+            const index_type& index() const noexcept
+            {
+                return m_index;
+            }
+
+            iterator& operator++() noexcept
+            {
+                ++m_position;
+                const order_type& order = m_owner->m_order;
+                for (std::size_t level = _Dims; level-- > 0;)
+                {
+                    const std::size_t d = order[level];
+                    if (++m_index[d] < std::min(m_origin[d] + m_owner->m_tile[d], m_owner->m_extent[d]))
+                        return *this;
+                    m_index[d] = m_origin[d];
+                }
+                // The tile is exhausted; move to the next tile origin.
+                for (std::size_t level = _Dims; level-- > 0;)
+                {
+                    const std::size_t d = order[level];
+                    m_origin[d] += m_owner->m_tile[d];
+                    if (m_origin[d] < m_owner->m_extent[d])
+                        break;
+                    m_origin[d] = 0;
+                }
+                m_index = m_origin;
+                return *this;
+            }
+
+            iterator operator++(int) noexcept
+            {
+                iterator temp = *this;
+                ++(*this);
+                return temp;
+            }
+
+            bool operator==(const iterator& right) const noexcept
+            {
+                return m_position == right.m_position;
+            }
+
+            bool operator!=(const iterator& right) const noexcept
+            {
+                return !this->operator==(right);
+            }
+
+        private:
+            const nd_range* m_owner = nullptr;
+            index_type m_index{};       // Multi-index of the current element.
+            index_type m_origin{};      // Multi-index of the first element of the current tile.
+            size_type m_position = 0;   // Number of elements visited.
+        };
+
+        nd_range() = default;
+
+        nd_range(const std::array<range<_Ty>, _Dims>& ranges) noexcept
+            : m_ranges(ranges)
+        {
+            for (std::size_t d = 0; d < _Dims; ++d)
+            {
+                m_extent[d] = static_cast<std::ptrdiff_t>(m_ranges[d].end() - m_ranges[d].begin());
+                m_tile[d] = std::max<std::ptrdiff_t>(m_extent[d], 1);
+                m_order[d] = d;
+            }
+        }
+
+        template <class... _Ranges, std::enable_if_t<sizeof...(_Ranges) == _Dims && (sizeof...(_Ranges) > 1), int> = 0>
+        nd_range(const _Ranges&... ranges) noexcept
+            : nd_range(std::array<range<_Ty>, _Dims>{ { ranges... } }) {}
+
+        // A copy traversed in tiles of the given shape. A tile extent of 0 covers the whole dimension.
+        _NPS_NODISCARD nd_range tiled(const index_type& tile) const noexcept
+        {
+            nd_range result = *this;
+            for (std::size_t d = 0; d < _Dims; ++d)
+                result.m_tile[d] = std::max<std::ptrdiff_t>((tile[d] > 0) ? std::min(tile[d], m_extent[d]) : m_extent[d], 1);
+            return result;
+        }
+
+        // A copy whose loops run in the given order, outermost dimension first.
+        _NPS_NODISCARD nd_range ordered(const order_type& order) const noexcept
+        {
+            nd_range result = *this;
+            result.m_order = order;
+            return result;
+        }
+
+        // A copy whose loop order puts the dimension with the smallest absolute memory stride innermost,
+        // so consecutive elements touch neighbouring memory.
+        _NPS_NODISCARD nd_range ordered_by_strides(const index_type& strides) const noexcept
+        {
+            order_type order = m_order;
+            std::stable_sort(order.begin(), order.end(), [&strides](std::size_t a, std::size_t b)
+            {
+                return std::abs(strides[a]) > std::abs(strides[b]);
+            });
+            return ordered(order);
+        }
+
+        // Halves in O(1) along the outermost dimension that has more than one element.
+        _NPS_NODISCARD std::pair<nd_range, nd_range> split() const noexcept
+        {
+            std::pair<nd_range, nd_range> result(*this, *this);
+            for (const std::size_t d : m_order)
+            {
+                if (m_extent[d] < 2)
+                    continue;
+                const std::ptrdiff_t mid = m_extent[d] / 2;
+                result.first.m_ranges[d] = m_ranges[d].slice(0, static_cast<typename range_type::size_type>(mid));
+                result.second.m_ranges[d] = m_ranges[d].slice(static_cast<typename range_type::size_type>(mid), static_cast<typename range_type::size_type>(m_extent[d]));
+                result.first.m_extent[d] = mid;
+                result.second.m_extent[d] = m_extent[d] - mid;
+                result.first.m_tile[d] = std::min(m_tile[d], mid);
+                result.second.m_tile[d] = std::min(m_tile[d], m_extent[d] - mid);
+                break;
+            }
+            return result;
+        }
+
+        _NPS_NODISCARD const range_type& dimension(std::size_t d) const noexcept
+        {
+            return m_ranges[d];
+        }
+
+        _NPS_NODISCARD const index_type& extents() const noexcept
+        {
+            return m_extent;
+        }
+
+        _NPS_NODISCARD const index_type& tile_shape() const noexcept
+        {
+            return m_tile;
+        }
+
+        _NPS_NODISCARD const order_type& order() const noexcept
         {
-            iterator it = begin();
-            while (it != end() && predicate(static_cast<_Uty>(*it)))
-                ++it;
-            return it;
+            return m_order;
         }
 
-        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
-        constexpr bool all_of(bool (*predicate)(_Uty)) const noexcept
+        _NPS_NODISCARD size_type size() const noexcept
+        {
+            size_type result = 1;
+            for (const std::ptrdiff_t extent : m_extent)
+                result *= extent;
+            return result;
+        }
+
+        _NPS_NODISCARD bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        // Row-major position of a multi-index, dimension 0 slowest, independent of the loop order and tiling.
+        _NPS_NODISCARD size_type flatten(const index_type& index) const noexcept
+        {
+            size_type result = 0;
+            for (std::size_t d = 0; d < _Dims; ++d)
+                result = result * m_extent[d] + index[d];
+            return result;
+        }
+
+        // Inverse of flatten().
+        _NPS_NODISCARD index_type unflatten(size_type position) const noexcept
+        {
+            index_type result{};
+            for (std::size_t d = _Dims; d-- > 0;)
+            {
+                result[d] = position % m_extent[d];
+                position /= m_extent[d];
+            }
+            return result;
+        }
+
+        _NPS_NODISCARD value_type at(const index_type& index) const noexcept
+        {
+            value_type result{};
+            for (std::size_t d = 0; d < _Dims; ++d)
+                result[d] = m_ranges[d].begin()[index[d]];
+            return result;
+        }
+
+        _NPS_NODISCARD size_type tile_count() const noexcept
+        {
+            size_type result = 1;
+            for (std::size_t d = 0; d < _Dims; ++d)
+                result *= (m_extent[d] + m_tile[d] - 1) / m_tile[d];
+            return result;
+        }
+
+        // Multi-index of the first element of a tile, numbering the tiles in the loop order.
+        _NPS_NODISCARD index_type tile_origin(size_type tile) const noexcept
+        {
+            index_type result{};
+            for (std::size_t level = _Dims; level-- > 0;)
+            {
+                const std::size_t d = m_order[level];
+                const std::ptrdiff_t tiles = (m_extent[d] + m_tile[d] - 1) / m_tile[d];
+                result[d] = (tile % tiles) * m_tile[d];
+                tile /= tiles;
+            }
+            return result;
+        }
+
+        // Calls func(x0, x1, ...) for every element, with the loop nest expanded at compile time.
+        template <class _Fn>
+        void for_each(_Fn&& func) const
+        {
+            if (empty())
+                return;
+            value_type value{};
+            index_type origin{};
+            visit_tiles<0>(func, value, origin);
+        }
+
+        // Calls func(x0, x1, ...) for the elements of the tile starting at origin.
+        template <class _Fn>
+        void for_each_in_tile(const index_type& origin, _Fn&& func) const
+        {
+            if (in_declared_order())
+            {
+                visit_in_order<0>(func, origin);
+                return;
+            }
+            value_type value{};
+            visit_elements<0>(func, value, origin);
+        }
+
+        _NPS_NODISCARD iterator begin() const noexcept
+        {
+            return iterator(this, 0);
+        }
+
+        _NPS_NODISCARD iterator end() const noexcept
+        {
+            return iterator(this, size());
+        }
+
+    private:
+        template <std::size_t _Level, class _Fn>
+        void visit_tiles(_Fn& func, value_type& value, index_type& origin) const
+        {
+            const std::size_t d = m_order[_Level];
+            for (origin[d] = 0; origin[d] < m_extent[d]; origin[d] += m_tile[d])
+            {
+                if constexpr (_Level + 1 < _Dims)
+                    visit_tiles<_Level + 1>(func, value, origin);
+                else
+                    for_each_in_tile(origin, func);
+            }
+        }
+
+        template <std::size_t _Level, class _Fn>
+        void visit_elements(_Fn& func, value_type& value, const index_type& origin) const
+        {
+            const std::size_t d = m_order[_Level];
+            const auto first = m_ranges[d].begin();
+            const std::ptrdiff_t limit = std::min(origin[d] + m_tile[d], m_extent[d]);
+            for (std::ptrdiff_t i = origin[d]; i < limit; ++i)
+            {
+                value[d] = first[i];
+                if constexpr (_Level + 1 < _Dims)
+                    visit_elements<_Level + 1>(func, value, origin);
+                else
+                    std::apply(func, value);
+            }
+        }
+
+        bool in_declared_order() const noexcept
         {
-            for (auto val : *this)
+            for (std::size_t d = 0; d < _Dims; ++d)
             {
-                if (!predicate(static_cast<_Uty>(val)))
+                if (m_order[d] != d)
                     return false;
             }
             return true;
         }
 
-        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
-        constexpr bool any_of(bool (*predicate)(_Uty)) const noexcept
+        // Loop nest for the declared order. The coordinates travel as arguments instead of through an array
+        // indexed at runtime, so they stay in registers like the counters of hand-written nested loops.
+        template <std::size_t _Level, class _Fn, class... _Values>
+        void visit_in_order(_Fn& func, const index_type& origin, _Values... values) const
         {
-            for (auto val : *this)
+            const auto first = m_ranges[_Level].begin();
+            const std::ptrdiff_t limit = std::min(origin[_Level] + m_tile[_Level], m_extent[_Level]);
+            for (std::ptrdiff_t i = origin[_Level]; i < limit; ++i)
             {
-                if (predicate(static_cast<_Uty>(val)))
-                    return true;
+                if constexpr (_Level + 1 < _Dims)
+                    visit_in_order<_Level + 1>(func, origin, values..., first[i]);
+                else
+                    func(values..., first[i]);
             }
-            return false;
         }
 
-        template <class _Uty, std::enable_if_t<std::is_arithmetic_v<_Uty>, int> = 0>
-        constexpr bool none_of(bool (*predicate)(_Uty)) const noexcept
+        std::array<range<_Ty>, _Dims> m_ranges{};
+        index_type m_extent{};      // Number of elements of each dimension.
+        index_type m_tile{};        // Tile extent of each dimension.
+        order_type m_order{};       // Dimensions from the outermost loop to the innermost.
+    };
+
+    template <class _Ty, class... _Rest>
+    nd_range(range<_Ty>, _Rest...) -> nd_range<_Ty, sizeof...(_Rest) + 1>;
+
+    // Calls func(x0, x1, ...) for every element of r on the threads of pool. Tiles are the units of work;
+    // an untiled range is cut into slabs along its outermost loop dimension. grain_size counts tiles.
+    template <class _Ty, std::size_t _Dims, class _Fn>
+    void parallel_for(const nd_range<_Ty, _Dims>& r, _Fn&& func, std::size_t grain_size = 0, thread_pool& pool = default_thread_pool())
+    {
+        if (r.empty())
+            return;
+        nd_range<_Ty, _Dims> work = r;
+        if (work.tile_count() == 1)
         {
-            return !any_of(predicate);
+            auto tile = work.tile_shape();
+            tile[work.order()[0]] = 1;
+            work = work.tiled(tile);
         }
+        const auto tiles = static_cast<std::size_t>(work.tile_count());
+        if (grain_size == 0)
+            grain_size = std::max<std::size_t>(1, tiles / (pool.size() * 16));
+        pool.run(tiles, grain_size, [&](std::size_t lo, std::size_t hi)
+        {
+            for (std::size_t tile = lo; tile < hi; ++tile)
+                work.for_each_in_tile(work.tile_origin(static_cast<std::ptrdiff_t>(tile)), func);
+        });
+    }
+
+    // Space-filling curves used by curve_range to order the elements of a product of ranges.
+    enum class curve_order
+    {
+        morton,     // Z-order: the bits of the indices interleaved.
+        hilbert     // Hilbert curve: consecutive elements are always neighbours.
+    };
 
-        constexpr bool contains(_Ty value) const noexcept
+    namespace detail
+    {
+        // Lane masks of the interleaved codes: lane l of a _Dims-dimensional code holds every _Dims-th bit from bit l.
+        template <std::size_t _Dims>
+        constexpr unsigned long long interleave_mask(std::size_t lane) noexcept
         {
-            // todo: check
-            if (m_step > 0)
-                return value >= m_start && value < m_end && ((value - m_start) % m_step == 0);
-            return value <= m_start && value > m_end && ((m_start - value) % (-m_step) == 0);
+            if constexpr (_Dims == 2)
+                return 0x5555555555555555ULL << lane;
+            else
+                return 0x1249249249249249ULL << lane;
         }
 
-        constexpr bool empty() const noexcept
+        // Moves the low bits of value to lane 0 of an interleaved code.
+        template <std::size_t _Dims>
+        inline unsigned long long spread_bits(unsigned long long value) noexcept
         {
-            return size() == 0;
+#if defined(_NPS_BMI2)
+            return _pdep_u64(value, interleave_mask<_Dims>(0));
+#else  // defined(_NPS_BMI2)
+            if constexpr (_Dims == 2)
+            {
+                value &= 0x00000000FFFFFFFFULL;
+                value = (value | (value << 16)) & 0x0000FFFF0000FFFFULL;
+                value = (value | (value << 8)) & 0x00FF00FF00FF00FFULL;
+                value = (value | (value << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+                value = (value | (value << 2)) & 0x3333333333333333ULL;
+                return (value | (value << 1)) & 0x5555555555555555ULL;
+            }
+            else
+            {
+                value &= 0x00000000001FFFFFULL;
+                value = (value | (value << 32)) & 0x001F00000000FFFFULL;
+                value = (value | (value << 16)) & 0x001F0000FF0000FFULL;
+                value = (value | (value << 8)) & 0x100F00F00F00F00FULL;
+                value = (value | (value << 4)) & 0x10C30C30C30C30C3ULL;
+                return (value | (value << 2)) & 0x1249249249249249ULL;
+            }
+#endif // defined(_NPS_BMI2)
         }
 
-        constexpr void swap(range& right) noexcept
+        // Inverse of spread_bits: gathers lane 0 of an interleaved code into the low bits.
+        template <std::size_t _Dims>
+        inline unsigned long long gather_bits(unsigned long long code) noexcept
         {
-            if (std::addressof(right) != this)
+#if defined(_NPS_BMI2)
+            return _pext_u64(code, interleave_mask<_Dims>(0));
+#else  // defined(_NPS_BMI2)
+            if constexpr (_Dims == 2)
             {
-                std::swap(m_start, right.m_start);
-                std::swap(m_end, right.m_end);
-                std::swap(m_step, right.m_step);
+                code &= 0x5555555555555555ULL;
+                code = (code | (code >> 1)) & 0x3333333333333333ULL;
+                code = (code | (code >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+                code = (code | (code >> 4)) & 0x00FF00FF00FF00FFULL;
+                code = (code | (code >> 8)) & 0x0000FFFF0000FFFFULL;
+                return (code | (code >> 16)) & 0x00000000FFFFFFFFULL;
+            }
+            else
+            {
+                code &= 0x1249249249249249ULL;
+                code = (code | (code >> 2)) & 0x10C30C30C30C30C3ULL;
+                code = (code | (code >> 4)) & 0x100F00F00F00F00FULL;
+                code = (code | (code >> 8)) & 0x001F0000FF0000FFULL;
+                code = (code | (code >> 16)) & 0x001F00000000FFFFULL;
+                return (code | (code >> 32)) & 0x00000000001FFFFFULL;
             }
+#endif // defined(_NPS_BMI2)
         }
 
-        std::vector<_Ty> to_vector() const
+        // Interleaves the axes so that axis 0 holds the most significant bit of every group.
+        template <std::size_t _Dims>
+        inline unsigned long long interleave(const std::array<unsigned long long, _Dims>& axes) noexcept
         {
-            std::vector<_Ty> result;
-            result.reserve(size());
-            for (_Ty item : (*this))
-                result.emplace_back(item);
+            unsigned long long code = 0;
+            for (std::size_t d = 0; d < _Dims; ++d)
+                code |= spread_bits<_Dims>(axes[d]) << (_Dims - 1 - d);
+            return code;
+        }
+
+        template <std::size_t _Dims>
+        inline std::array<unsigned long long, _Dims> deinterleave(unsigned long long code) noexcept
+        {
+            std::array<unsigned long long, _Dims> axes{};
+            for (std::size_t d = 0; d < _Dims; ++d)
+                axes[d] = gather_bits<_Dims>(code >> (_Dims - 1 - d));
+            return axes;
+        }
+
+        // Skilling's transform between cell coordinates and the transposed Hilbert index of a 2^bits cube.
+        // Interleaving the transposed form gives the position along the curve. O(bits * _Dims).
+        template <std::size_t _Dims>
+        inline void hilbert_axes_to_transpose(std::array<unsigned long long, _Dims>& x, unsigned bits) noexcept
+        {
+            const unsigned long long top = 1ULL << (bits - 1);
+            for (unsigned long long q = top; q > 1; q >>= 1)
+            {
+                const unsigned long long p = q - 1;
+                for (std::size_t i = 0; i < _Dims; ++i)
+                {
+                    if (x[i] & q)
+                        x[0] ^= p;
+                    else
+                    {
+                        const unsigned long long t = (x[0] ^ x[i]) & p;
+                        x[0] ^= t;
+                        x[i] ^= t;
+                    }
+                }
+            }
+            for (std::size_t i = 1; i < _Dims; ++i)
+                x[i] ^= x[i - 1];
+            unsigned long long t = 0;
+            for (unsigned long long q = top; q > 1; q >>= 1)
+            {
+                if (x[_Dims - 1] & q)
+                    t ^= q - 1;
+            }
+            for (std::size_t i = 0; i < _Dims; ++i)
+                x[i] ^= t;
+        }
+
+        template <std::size_t _Dims>
+        inline void hilbert_transpose_to_axes(std::array<unsigned long long, _Dims>& x, unsigned bits) noexcept
+        {
+            const unsigned long long limit = 2ULL << (bits - 1);
+            const unsigned long long t = x[_Dims - 1] >> 1;
+            for (std::size_t i = _Dims - 1; i > 0; --i)
+                x[i] ^= x[i - 1];
+            x[0] ^= t;
+            for (unsigned long long q = 2; q != limit; q <<= 1)
+            {
+                const unsigned long long p = q - 1;
+                for (std::size_t i = _Dims; i-- > 0;)
+                {
+                    if (x[i] & q)
+                        x[0] ^= p;
+                    else
+                    {
+                        const unsigned long long s = (x[0] ^ x[i]) & p;
+                        x[0] ^= s;
+                        x[i] ^= s;
+                    }
+                }
+            }
+        }
+
+        // Decodes consecutive positions of a curve over a 2^bits cube, redoing only the levels of the code that
+        // changed since the previous position. Level b of the code holds bit b of every axis, and an increment
+        // carries into level b once every 2^(b * _Dims) positions, so stepping costs O(_Dims) amortized.
+        // For Hilbert order, bit b of the axes is the Gray-decoded level b permuted and complemented by the
+        // rotations of Skilling's transform at the levels above it; their composition is kept per level as a
+        // table of the 2^_Dims level values.
+        template <std::size_t _Dims, curve_order _Order>
+        class curve_decoder
+        {
+        public:
+            void reset(unsigned long long code, unsigned bits) noexcept
+            {
+                m_bits = bits;
+                m_code = code;
+                m_axes = {};
+                if constexpr (_Order == curve_order::hilbert)
+                {
+                    for (unsigned value = 0; value < cell_count; ++value)
+                        m_frames[bits - 1][value] = static_cast<unsigned char>(value);
+                }
+                decode(bits - 1);
+            }
+
+            void move_to(unsigned long long code) noexcept
+            {
+#if defined(_NPS_BMI2)
+                if constexpr (_Order == curve_order::morton)
+                {
+                    m_code = code;
+                    m_axes = deinterleave<_Dims>(code);
+                    return;
+                }
+#endif // defined(_NPS_BMI2)
+                unsigned level = 0;
+                for (unsigned long long changed = (m_code ^ code) >> _Dims; changed != 0; changed >>= _Dims)
+                    ++level;
+                m_code = code;
+                decode(level);
+            }
+
+            const std::array<unsigned long long, _Dims>& axes() const noexcept
+            {
+                return m_axes;
+            }
+
+        private:
+            static constexpr unsigned cell_count = 1u << _Dims;
+
+            using frame = std::array<unsigned char, cell_count>;
+
+            // Tables indexed by level values, whose bit i is bit b of axis i.
+            struct tables
+            {
+                frame from_digit{};                         // Level value of a digit of the code.
+                std::array<frame, cell_count> rotation{};   // Rotation of a level by the Gray-decoded level above.
+            };
+
+            static constexpr tables make_tables() noexcept
+            {
+                tables result{};
+                for (unsigned digit = 0; digit < cell_count; ++digit)
+                {
+                    unsigned value = 0;
+                    for (std::size_t i = 0; i < _Dims; ++i)
+                        value |= ((digit >> (_Dims - 1 - i)) & 1u) << i;
+                    result.from_digit[digit] = static_cast<unsigned char>(value);
+                }
+                // The rotations of Skilling's transform at a level: for i = _Dims - 1, ..., 0, axis 0 is
+                // complemented when bit i of the level is set and exchanged with axis i otherwise.
+                for (unsigned gray = 0; gray < cell_count; ++gray)
+                {
+                    for (unsigned value = 0; value < cell_count; ++value)
+                    {
+                        unsigned x = value;
+                        for (std::size_t i = _Dims; i-- > 0;)
+                        {
+                            if ((gray >> i) & 1u)
+                                x ^= 1u;
+                            else if (((x >> i) ^ x) & 1u)
+                                x ^= 1u | (1u << i);
+                        }
+                        result.rotation[gray][value] = static_cast<unsigned char>(x);
+                    }
+                }
+                return result;
+            }
+
+            static constexpr tables lookup = make_tables();
+
+            // Rewrites bit b of the axes for the levels b <= top.
+            void decode(unsigned top) noexcept
+            {
+                top = std::min(top, m_bits - 1);
+                const unsigned long long low = (2ULL << top) - 1;
+                for (std::size_t i = 0; i < _Dims; ++i)
+                    m_axes[i] &= ~low;
+                unsigned above = 0;
+                for (unsigned level = top + 1; level-- > 0;)
+                {
+                    unsigned value = lookup.from_digit[static_cast<unsigned>(m_code >> (level * _Dims)) & (cell_count - 1)];
+                    if constexpr (_Order == curve_order::hilbert)
+                    {
+                        // Gray decoding; axis 0 also takes bit b + 1 of the last axis.
+                        const unsigned carry = (level + 1 < m_bits) ? static_cast<unsigned>(m_code >> ((level + 1) * _Dims)) & 1u : 0u;
+                        const unsigned gray = (value ^ (value << 1) ^ carry) & (cell_count - 1);
+                        if (level != top)
+                        {
+                            for (unsigned cell = 0; cell < cell_count; ++cell)
+                                m_frames[level][cell] = m_frames[level + 1][lookup.rotation[above][cell]];
+                        }
+                        value = m_frames[level][gray];
+                        above = gray;
+                    }
+                    for (std::size_t i = 0; i < _Dims; ++i)
+                        m_axes[i] |= static_cast<unsigned long long>((value >> i) & 1u) << level;
+                }
+            }
+
+            unsigned long long m_code = 0;
+            unsigned m_bits = 1;
+            std::array<unsigned long long, _Dims> m_axes{};
+            std::array<frame, (_Order == curve_order::hilbert) ? 64 / _Dims : 0> m_frames{};
+        };
+    }
+
+    // Product of 2 or 3 ranges visited along a space-filling curve instead of row-major order, for
+    // locality-sensitive traversals. The curve covers the smallest power-of-two cube holding the extents;
+    // blocks of cells outside the extents are skipped whole. A curve_range may be restricted to a contiguous
+    // segment of curve positions, which is how it is split between parallel workers.
+    template <class _Ty, std::size_t _Dims, curve_order _Order = curve_order::morton>
+    class curve_range
+    {
+        static_assert(_Dims == 2 || _Dims == 3, "curve_range supports 2 and 3 dimensions");
+    public:
+        using range_type    = range<_Ty>;
+        using value_type    = std::array<_Ty, _Dims>;
+        using index_type    = std::array<std::ptrdiff_t, _Dims>;
+        using code_type     = unsigned long long;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = typename curve_range::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = value_type;
+
+            iterator() = default;
+
+            iterator(const curve_range* owner, code_type code) noexcept
+                : m_owner(owner), m_code(code), m_index()
+            {
+                if (m_code < m_owner->m_last)
+                    m_decoder.reset(m_code, m_owner->m_bits);
+                settle();
+            }
+
+            value_type operator*() const
+            {
+                return m_owner->at(m_index);
+            }
+
+            // Multi-index of the current element.
+            const index_type& index() const noexcept
+            {
+                return m_index;
+            }
+
+            // Position of the current element along the curve.
+            code_type code() const noexcept
+            {
+                return m_code;
+            }
+
+            // Decodes the next position from the current one, O(_Dims) amortized.
+            iterator& operator++() noexcept
+            {
+                ++m_code;
+                settle();
+                return *this;
+            }
+
+            iterator operator++(int) noexcept
+            {
+                iterator temp = *this;
+                ++(*this);
+                return temp;
+            }
+
+            bool operator==(const iterator& right) const noexcept
+            {
+                return m_code == right.m_code;
+            }
+
+            bool operator!=(const iterator& right) const noexcept
+            {
+                return !this->operator==(right);
+            }
+
+        private:
+            // Moves forward to the first position inside the extents, or to the end of the segment.
+            void settle() noexcept
+            {
+                while (m_code < m_owner->m_last)
+                {
+                    m_decoder.move_to(m_code);
+                    for (std::size_t d = 0; d < _Dims; ++d)
+                        m_index[d] = static_cast<std::ptrdiff_t>(m_decoder.axes()[d]);
+                    const unsigned level = m_owner->outside_level(m_index);
+                    if (level == 0)
+                        return;
+                    // Aligned blocks of 2^(level * _Dims) positions cover aligned cubes, so the whole block is outside.
+                    const code_type block = (code_type(1) << ((level - 1) * _Dims)) - 1;
+                    m_code = std::min(m_code | block, m_owner->m_last - 1) + 1;
+                }
+                m_code = m_owner->m_last;
+            }
+
+            const curve_range* m_owner = nullptr;
+            code_type m_code = 0;
+            index_type m_index{};
+            detail::curve_decoder<_Dims, _Order> m_decoder;
+        };
+
+        curve_range() = default;
+
+        curve_range(const std::array<range<_Ty>, _Dims>& ranges) noexcept
+            : m_ranges(ranges)
+        {
+            std::ptrdiff_t largest = 0;
+            for (std::size_t d = 0; d < _Dims; ++d)
+            {
+                m_extent[d] = static_cast<std::ptrdiff_t>(m_ranges[d].end() - m_ranges[d].begin());
+                largest = std::max(largest, m_extent[d]);
+            }
+            m_bits = 1;
+            while ((std::ptrdiff_t(1) << m_bits) < largest)
+                ++m_bits;
+            _NPS_ASSERT(m_bits * _Dims < 64, "curve_range extents are too large");
+            m_first = 0;
+            m_last = (largest == 0 || empty_extent()) ? 0 : (code_type(1) << (m_bits * _Dims));
+        }
+
+        template <class... _Ranges, std::enable_if_t<sizeof...(_Ranges) == _Dims, int> = 0>
+        curve_range(const _Ranges&... ranges) noexcept
+            : curve_range(std::array<range<_Ty>, _Dims>{ { ranges... } }) {}
+
+        // Curve position of a multi-index. O(1) for Morton order with BMI2, O(log n) otherwise.
+        _NPS_NODISCARD code_type rank(const index_type& index) const noexcept
+        {
+            std::array<unsigned long long, _Dims> axes{};
+            for (std::size_t d = 0; d < _Dims; ++d)
+                axes[d] = static_cast<unsigned long long>(index[d]);
+            if constexpr (_Order == curve_order::hilbert)
+                detail::hilbert_axes_to_transpose(axes, m_bits);
+            return detail::interleave(axes);
+        }
+
+        // Multi-index at a curve position; it may lie outside the extents.
+        _NPS_NODISCARD index_type unrank(code_type code) const noexcept
+        {
+            std::array<unsigned long long, _Dims> axes = detail::deinterleave<_Dims>(code);
+            if constexpr (_Order == curve_order::hilbert)
+                detail::hilbert_transpose_to_axes(axes, m_bits);
+            index_type index{};
+            for (std::size_t d = 0; d < _Dims; ++d)
+                index[d] = static_cast<std::ptrdiff_t>(axes[d]);
+            return index;
+        }
+
+        _NPS_NODISCARD value_type at(const index_type& index) const noexcept
+        {
+            value_type result{};
+            for (std::size_t d = 0; d < _Dims; ++d)
+                result[d] = m_ranges[d].begin()[index[d]];
             return result;
         }
-        
-        std::list<_Ty> to_list() const
+
+        // The elements whose curve positions lie in [first, last).
+        _NPS_NODISCARD curve_range segment(code_type first, code_type last) const noexcept
         {
-            std::list<_Ty> result;
-            for (_Ty item : (*this))
-                result.emplace_back(item);
+            curve_range result = *this;
+            result.m_first = std::max(first, m_first);
+            result.m_last = std::max(result.m_first, std::min(last, m_last));
             return result;
         }
 
-        _NPS_CONSTEXPR17 bool operator==(const range& right) const noexcept
+        // Halves the segment of curve positions in O(1).
+        _NPS_NODISCARD std::pair<curve_range, curve_range> split() const noexcept
         {
-            return m_start == right.m_start && m_end == right.m_end && m_step == right.m_step;
+            const code_type mid = m_first + (m_last - m_first) / 2;
+            return { segment(m_first, mid), segment(mid, m_last) };
         }
 
-        _NPS_CONSTEXPR17 bool operator!=(const range& right) const noexcept
+        _NPS_NODISCARD code_type code_begin() const noexcept
         {
-            return !(*this == right);
+            return m_first;
         }
 
-        _NPS_NODISCARD constexpr iterator begin() const noexcept
+        _NPS_NODISCARD code_type code_end() const noexcept
         {
-            return iterator(m_start, m_step);
+            return m_last;
         }
 
-        _NPS_NODISCARD constexpr iterator end() const noexcept
+        _NPS_NODISCARD const index_type& extents() const noexcept
+        {
+            return m_extent;
+        }
+
+        _NPS_NODISCARD bool empty() const noexcept
+        {
+            return begin() == end();
+        }
+
+        // Calls func(x0, x1, ...) for every element in curve order.
+        template <class _Fn>
+        void for_each(_Fn&& func) const
         {
-            return iterator(m_end, m_step);
+            for (const value_type& value : *this)
+                std::apply(func, value);
         }
 
-        _NPS_NODISCARD constexpr iterator rbegin() noexcept
+        _NPS_NODISCARD iterator begin() const noexcept
         {
-            return iterator(static_cast<_Ty>(m_end - m_step), -m_step);
+            return iterator(this, m_first);
         }
 
-        _NPS_NODISCARD constexpr iterator rend() noexcept
+        _NPS_NODISCARD iterator end() const noexcept
         {
-            return iterator(static_cast<_Ty>(m_start - m_step), -m_step);
+            return iterator(this, m_last);
         }
+
     private:
-        _Ty m_start;    // Start value of the range.
-        _Ty m_end;      // End value of the range.
-        step_type m_step; // Step value for iteration.
+        bool empty_extent() const noexcept
+        {
+            for (const std::ptrdiff_t extent : m_extent)
+            {
+                if (extent == 0)
+                    return true;
+            }
+            return false;
+        }
+
+        // 0 when index lies inside the extents, otherwise 1 + log2 of the side of the largest aligned cube
+        // containing index that lies entirely outside them.
+        unsigned outside_level(const index_type& index) const noexcept
+        {
+            unsigned level = 0;
+            while (level <= m_bits)
+            {
+                bool outside = false;
+                for (std::size_t d = 0; d < _Dims; ++d)
+                    outside = outside || ((index[d] >> level) << level) >= m_extent[d];
+                if (!outside)
+                    break;
+                ++level;
+            }
+            return level;
+        }
+
+        std::array<range<_Ty>, _Dims> m_ranges{};
+        index_type m_extent{};  // Number of elements of each dimension.
+        unsigned m_bits = 1;    // log2 of the side of the cube covered by the curve.
+        code_type m_first = 0;  // Segment of curve positions visited.
+        code_type m_last = 0;
     };
 
-    // Swap function for range objects.
-    // @param lhs The left-hand side range to swap.
-    // @param rhs The right-hand side range to swap.
-    template <class _Ty>
-    void swap(range<_Ty>& lhs, range<_Ty>& rhs)
+    // Visits the product of the ranges in Morton (Z) order.
+    template <class _Ty, class... _Rest>
+    curve_range<_Ty, sizeof...(_Rest) + 1, curve_order::morton> morton_order(const range<_Ty>& first, const _Rest&... rest)
     {
-        lhs.swap(rhs);
+        return { first, rest... };
     }
 
-    // Type aliases for common numeric ranges.
-    // These types allow convenient access to common range types for various data types.
-
-    using crange = range<char>;
-    using ucrange = range<unsigned char>;
-    using srange = range<short>;
-    using usrange = range<unsigned short>;
-    using irange = range<int>;
-    using uirange = range<unsigned int>;
-    using lrange = range<long>;
-    using ulrange = range<unsigned long>;
-    using llrange = range<long long>;
-    using ullrange = range<unsigned long long>;
-    using frange = range<float>;
-    using drange = range<double>;
-    using ldrange = range<long double>;
+    // Visits the product of the ranges in Hilbert order.
+    template <class _Ty, class... _Rest>
+    curve_range<_Ty, sizeof...(_Rest) + 1, curve_order::hilbert> hilbert_order(const range<_Ty>& first, const _Rest&... rest)
+    {
+        return { first, rest... };
+    }
 
-    template <class _Ty = int, std::enable_if_t<std::is_arithmetic_v<_Ty>, int> = 0>
-    constexpr range<_Ty> empty_range = range{};
+    // Calls func(x0, x1, ...) for every element of r on the threads of pool. Each thread visits contiguous
+    // segments of the curve, so every worker keeps the locality of the curve. grain_size counts curve positions.
+    template <class _Ty, std::size_t _Dims, curve_order _Order, class _Fn>
+    void parallel_for(const curve_range<_Ty, _Dims, _Order>& r, _Fn&& func, std::size_t grain_size = 0, thread_pool& pool = default_thread_pool())
+    {
+        const auto first = r.code_begin();
+        const auto count = static_cast<std::size_t>(r.code_end() - first);
+        if (count == 0)
+            return;
+        if (grain_size == 0)
+            grain_size = std::max<std::size_t>(1, count / (pool.size() * 16));
+        pool.run(count, grain_size, [&](std::size_t lo, std::size_t hi)
+        {
+            r.segment(first + lo, first + hi).for_each(func);
+        });
+    }
 }
 
+#if defined(__cpp_lib_ranges)
+// Ranges are cheap to copy views whose iterators do not refer back to the range object,
+// so they also work with the std::ranges algorithms and adaptors when passed as temporaries.
+// range is a sized, common, random-access view; circular_range and patterned_range are input views.
+template <class _Ty, int _Tag>
+inline constexpr bool std::ranges::enable_view<nps::range<_Ty, _Tag>> = true;
+template <class _Ty, int _Tag>
+inline constexpr bool std::ranges::enable_borrowed_range<nps::range<_Ty, _Tag>> = true;
+template <class _Ty, int _Tag>
+inline constexpr bool std::ranges::enable_view<nps::circular_range<_Ty, _Tag>> = true;
+template <class _Ty, int _Tag>
+inline constexpr bool std::ranges::enable_borrowed_range<nps::circular_range<_Ty, _Tag>> = true;
+template <class _Ty, class _Fn, int _Tag>
+inline constexpr bool std::ranges::enable_view<nps::patterned_range<_Ty, _Fn, _Tag>> = true;
+template <class _Ty, class _Fn, int _Tag>
+inline constexpr bool std::ranges::enable_borrowed_range<nps::patterned_range<_Ty, _Fn, _Tag>> = true;
+template <class _Ty, _Ty _Start, _Ty _End, long long _Step>
+inline constexpr bool std::ranges::enable_view<nps::static_range<_Ty, _Start, _End, _Step>> = true;
+template <class _Ty, _Ty _Start, _Ty _End, long long _Step>
+inline constexpr bool std::ranges::enable_borrowed_range<nps::static_range<_Ty, _Start, _End, _Step>> = true;
+#endif // defined(__cpp_lib_ranges)
+
 #if defined(_MSC_VER) && !_HAS_CXX17
     #pragma warning(pop)
 #endif // !_HAS_CXX17